@@ -29,15 +29,38 @@ public:
 			MACS_ALARM(AR_NOT_IN_PRIVILEGED);
 
 		m_prev_interrupt_mask = System::DisableIrq();
+#if MACS_PROFILING_ENABLED
+		if ( ! m_prev_interrupt_mask )
+			m_enter_tick = System::GetCurCpuTick();
+#endif
 	}
 	inline ~CriticalSection() {
+#if MACS_PROFILING_ENABLED
+		// учитывается только секция верхнего уровня, вложенные входят в ее время
+		if ( ! m_prev_interrupt_mask ) {
+			const uint32_t cycles = System::GetCurCpuTick() - m_enter_tick;
+			if ( cycles > s_max_masked )
+				s_max_masked = cycles;
+		}
+#endif
 		System::EnableIrq(m_prev_interrupt_mask);
 	}
 
+#if MACS_PROFILING_ENABLED
+	/// @brief Наибольшее время, в течение которого прерывания были замаскированы критической секцией, в тактах процессора.
+	static inline uint32_t GetMaxMasked() { return s_max_masked; }
+	/// @brief Сбрасывает наибольшее время маскирования прерываний.
+	static inline void ClearMaxMasked() { s_max_masked = 0; }
+#endif
+
 private:
 	CLS_COPY(CriticalSection)
 private:
 	uint32_t m_prev_interrupt_mask;
+#if MACS_PROFILING_ENABLED
+	uint32_t m_enter_tick;
+	static volatile uint32_t s_max_masked;
+#endif
 };
 
 }	// namespace macs
@@ -38,6 +38,7 @@ public:
 	
 	/// @brief Сигнализировать о наступлении события
 	/// @details Дает сигнал на разблокировку задачи или всех задач, ожидающих данного события.
+	/// При вызове из прерывания (MACS_IRQ_POST) сигнал выдается отложенно, перед переключением контекста.
 	/// @return [Результат операции](@ref macs::Result)
 	Result Raise();
 
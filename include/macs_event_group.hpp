@@ -0,0 +1,103 @@
+/// @file macs_event_group.hpp
+/// @brief Группы событий.
+/// @details Группа событий хранит 32 флага, которые могут устанавливаться и сбрасываться задачами
+/// и обработчиками прерываний. Задача может ожидать установки любого (WaitAny) или всех (WaitAll)
+/// флагов из указанной маски, поэтому одна задача может ожидать нескольких условий без цепочки
+/// объектов Event и без опроса.
+/// @copyright AstroSoft Ltd, 2016
+
+#pragma once
+
+#include "macs_scheduler.hpp"
+
+#if MACS_EVENT_GROUPS
+
+namespace macs {
+
+/// @brief Класс для представления группы событий.
+/// @details В отличие от Event, группа событий имеет сигнальное состояние: установленный флаг
+/// сохраняется, пока не будет сброшен явно (Clear) или при получении его ожидающей задачей (auto_clear).
+class EventGroup : public SyncObject
+{
+public:
+	/// @brief Конструктор группы событий
+	/// @param flags - начальное значение флагов
+	EventGroup(uint32_t flags = 0);
+
+	~EventGroup();
+
+	/// @brief Получить текущее значение флагов
+	uint32_t Get() const { return m_flags; }
+
+	/// @brief Установить флаги
+	/// @details Устанавливает указанные флаги и разблокирует все задачи, условия ожидания которых
+	/// выполнены, с однократным перепланированием. Флаги, полученные задачами с auto_clear, сбрасываются
+	/// после разблокировки всех задач. Метод можно вызывать из обработчиков прерываний, при MACS_IRQ_POST
+	/// флаги из прерывания устанавливаются отложенно, перед переключением контекста.
+	/// @param flags - маска устанавливаемых флагов
+	/// @return [Результат операции](@ref macs::Result)
+	Result Set(uint32_t flags);
+
+	/// @brief Сбросить флаги
+	/// @details Метод можно вызывать из обработчиков прерываний. При MACS_IRQ_POST сброс из прерывания
+	/// также выполняется отложенно, чтобы сохранить порядок относительно Set.
+	/// @param flags - маска сбрасываемых флагов
+	/// @return [Результат операции](@ref macs::Result)
+	Result Clear(uint32_t flags);
+
+	/// @brief Ждать установки любого из флагов
+	/// @details Если хотя бы один из флагов маски уже установлен, возвращает управление немедленно.
+	/// @param mask - маска ожидаемых флагов
+	/// @param flags - значение всех флагов на момент выполнения условия (при таймауте - текущее значение)
+	/// @param auto_clear - сбросить флаги маски при выполнении условия
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	Result WaitAny(uint32_t mask, uint32_t & flags, bool auto_clear = true, uint32_t timeout_ms = INFINITE_TIMEOUT)
+		{ return Wait(mask, flags, auto_clear ? WaitAutoClear : 0, timeout_ms); }
+
+	/// @brief Ждать установки всех флагов
+	/// @details Если все флаги маски уже установлены, возвращает управление немедленно.
+	/// @param mask - маска ожидаемых флагов
+	/// @param flags - значение всех флагов на момент выполнения условия (при таймауте - текущее значение)
+	/// @param auto_clear - сбросить флаги маски при выполнении условия
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	Result WaitAll(uint32_t mask, uint32_t & flags, bool auto_clear = true, uint32_t timeout_ms = INFINITE_TIMEOUT)
+		{ return Wait(mask, flags, WaitAllFlags | (auto_clear ? WaitAutoClear : 0), timeout_ms); }
+
+	// Параметры ожидания, передаваемые ядру
+	enum WaitOption
+	{
+		WaitAllFlags  = 1,  // ждать всех флагов маски (иначе - любого)
+		WaitAutoClear = 2   // сбросить флаги маски при выполнении условия
+	};
+	struct WaitArgs
+	{
+		uint32_t m_mask;
+		uint32_t m_options;
+	};
+
+	static Result Set_Priv(EventGroup * group, uint32_t flags);                                       // Только для вызова ядром
+	static Result Clear_Priv(EventGroup * group, uint32_t flags);                                     // Только для вызова ядром
+	static Result Wait_Priv(EventGroup * group, const WaitArgs * args, uint32_t timeout_ms);          // Только для вызова ядром
+
+#if MACS_WAIT_MULTIPLE
+	// через WaitMultiple сообщается только о наличии установленных флагов
+	virtual bool TryTake(Task *) { return m_flags != 0; }
+#endif
+
+private:
+	CLS_COPY(EventGroup)
+
+	Result Wait(uint32_t mask, uint32_t & flags, uint32_t options, uint32_t timeout_ms);
+
+	static inline bool IsSatisfied(uint32_t flags, uint32_t mask, uint32_t options) {
+		return (options & WaitAllFlags) ? (flags & mask) == mask : (flags & mask) != 0;
+	}
+
+	volatile uint32_t m_flags;
+};
+
+}	// namespace macs
+
+#endif
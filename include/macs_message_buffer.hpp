@@ -0,0 +1,136 @@
+/// @file macs_message_buffer.hpp
+/// @brief Буфер сообщений переменной длины.
+/// @details В отличие от очереди сообщений (MessageQueue), элементы которой имеют фиксированный
+/// размер, буфер сообщений хранит записи произвольной длины (с префиксом длины) подряд в одном
+/// кольцевом буфере, поэтому память расходуется пропорционально реальному размеру сообщений.
+/// Каждая запись располагается в памяти непрерывно: если запись не помещается в конце буфера,
+/// остаток буфера пропускается и запись размещается с его начала. Благодаря этому сообщение
+/// можно обработать на месте, без копирования (Acquire/Release).
+/// @copyright AstroSoft Ltd, 2016
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "macs_common.hpp"
+#include "macs_semaphore.hpp"
+#include "macs_buffer.hpp"
+
+namespace macs {
+
+/// @brief Класс для представления буфера сообщений переменной длины.
+/// @details Буфер предназначен для обмена сообщениями между задачами. Отправители и получатели
+/// согласуются паузой планировщика, поэтому методы нельзя вызывать из обработчиков прерываний
+/// (для потоков данных от прерываний следует использовать SpscRing). Отправителей и получателей может быть
+/// несколько: при освобождении места (поступлении данных) разблокируются все ожидающие отправители (получатели),
+/// и каждый из них повторяет попытку.
+class MessageBuffer
+{
+public:
+	/// @brief Конструктор буфера сообщений
+	/// @param size - размер буфера в байтах (с учетом заголовков записей, по 4 байта на сообщение)
+	/// @param mem - указатель на внешнюю память размером size байт, выровненную на 4 байта
+	MessageBuffer(size_t size, byte * mem = nullptr);
+	~MessageBuffer();
+
+	/// @brief Отправить сообщение
+	/// @details Копирует сообщение в буфер. Если места недостаточно, задача будет заблокирована
+	/// до его освобождения, либо до истечения таймаута.
+	/// @param data - сообщение
+	/// @param len - длина сообщения в байтах (не более GetMaxMessageSize())
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	Result Send(const void * data, size_t len, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+	/// @brief Отправить содержимое буфера Buf как одно сообщение
+	Result Send(const Buf & buf, uint32_t timeout_ms = INFINITE_TIMEOUT) { return Send(buf.Data(), buf.Len(), timeout_ms); }
+
+	/// @brief Получить сообщение
+	/// @details Копирует первое сообщение буфера и удаляет его из буфера. Если сообщений нет (или их объем
+	/// меньше уровня срабатывания), задача будет заблокирована до их поступления, либо до истечения таймаута.
+	/// @param data - буфер для сообщения
+	/// @param max_len - размер буфера data
+	/// @param len - длина полученного сообщения
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result). Если сообщение не помещается в data,
+	/// возвращается ResultErrorInvalidArgs, а сообщение остается в буфере.
+	Result Receive(void * data, size_t max_len, size_t & len, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+	/// @brief Получить сообщение в буфер Buf
+	/// @details Содержимое buf заменяется сообщением. Буфер с динамическим размером при необходимости увеличивается.
+	Result Receive(Buf & buf, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+	/// @brief Получить доступ к первому сообщению без копирования
+	/// @details Сообщение остается в буфере до вызова Release. Одновременно допускается только один такой доступ:
+	/// другие получатели ожидают вызова Release, повторный вызов Acquire той же задачей возвращает ошибку.
+	/// @param data - переменная, в которую будет помещен указатель на сообщение
+	/// @param len - длина сообщения
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	Result Acquire(const byte * & data, size_t & len, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+	/// @brief Удалить из буфера сообщение, полученное Acquire
+	/// @return [Результат операции](@ref macs::Result)
+	Result Release();
+
+	/// @brief Установить уровень срабатывания
+	/// @details Получатель разблокируется, когда объем записей в буфере достигнет указанного количества байт
+	/// (по умолчанию - при поступлении любого сообщения). По истечении таймаута получатель забирает то, что есть.
+	/// @param level - уровень срабатывания в байтах
+	void SetTriggerLevel(size_t level) { m_trigger = level ? level : 1; }
+
+	/// @brief Получить количество сообщений в буфере
+	size_t Count() const { return m_count; }
+
+	/// @brief Получить объем, занятый записями (в байтах)
+	size_t GetUsed() const { return m_used; }
+
+	/// @brief Получить размер буфера в байтах
+	size_t GetSize() const { return m_size; }
+
+	/// @brief Получить максимальную длину сообщения
+	size_t GetMaxMessageSize() const { return m_size - HDR_SIZE; }
+
+private:
+	CLS_COPY(MessageBuffer)
+
+	static const size_t HDR_SIZE = sizeof(uint32_t);
+	static const uint32_t WRAP_MARK = 0xFFFFFFFF;	// остаток буфера до конца пропущен
+
+	// Место, занимаемое записью: заголовок и данные с выравниванием на 4 байта
+	static inline size_t Span(size_t len) { return HDR_SIZE + ((len + 3) & ~ 3u); }
+
+	// Смещение для записи размером span (pad - пропускаемый остаток буфера) или m_size, если места нет
+	size_t Place(size_t span, size_t & pad);
+	// Выдает первую запись получателю, вызывается под паузой
+	void TakeHead(const byte * & data, size_t & len);
+	// Удаляет первую запись, вызывается под паузой
+	void Drop();
+	// Возвращает выданную запись в буфер без удаления
+	void Unacquire();
+	// Разблокирует все ожидающие задачи, вызывается под паузой
+	static void WakeAll(Semaphore & sem, size_t & waiters, uint32_t & gen);
+	// Снимает регистрацию ожидающей задачи, если ее не разблокировали (gen - номер разблокировки при регистрации)
+	static void LeaveWait(size_t & waiters, uint32_t cur_gen, uint32_t gen);
+
+	byte * m_mem;
+	size_t m_size;
+	bool m_is_alien_mem;
+
+	size_t m_head;          // смещение первой записи
+	size_t m_tail;          // смещение для следующей записи
+	size_t m_used;          // байт занято записями и пропусками
+	size_t m_count;         // количество сообщений
+	size_t m_trigger;       // уровень срабатывания в байтах
+	Task * m_acquirer;      // задача, которой первое сообщение выдано Acquire
+	size_t m_recv_waiters;  // количество получателей, ожидающих данных
+	size_t m_send_waiters;  // количество отправителей, ожидающих места
+	uint32_t m_recv_gen;    // номер разблокировки получателей
+	uint32_t m_send_gen;    // номер разблокировки отправителей
+
+	Semaphore m_data_sem;
+	Semaphore m_space_sem;
+};
+
+}	// namespace macs
@@ -66,6 +66,19 @@ public:
 
 };	// class MessageQueueInterface
 
+#if MACS_WAIT_MULTIPLE
+// Семафор наличия сообщений в очереди. При ожидании через WaitMultiple только сообщает
+// о наличии сообщения, не захватывая его: сообщение забирается вызовом Pop с нулевым таймаутом.
+class MessageQueueSemaphore : public Semaphore
+{
+public:
+	MessageQueueSemaphore(size_t start_count, size_t max_count) : Semaphore(start_count, max_count) {}
+	virtual bool TryTake(Task *) { return GetCurrentCount() != 0; }
+};
+#else
+typedef Semaphore MessageQueueSemaphore;
+#endif
+
 /// @brief Шаблон класса для представления очереди сообщений
 /// @details Класс реализует функционал обмена сообщениями между задачами приложения (на одном процессоре).
 /// Параметром шаблона является тип сообщения (например, скалярный тип, структура или класс).
@@ -118,6 +131,67 @@ public:
 	/// @brief Получить максимальную длину очереди
 	/// @return Максимально возможное количество сообщений в очереди
 	virtual size_t GetMaxSize() const { return m_len - 1; }	
+
+	/// @brief Зарезервировать место в конце очереди
+	/// @details Получает указатель на свободный элемент очереди, в который производитель записывает
+	/// сообщение без промежуточного копирования. Сообщение становится доступным получателям после
+	/// вызова Commit. Если очередь переполнена, задача будет заблокирована до появления свободного места,
+	/// либо до истечения таймаута. Одновременно допускается только одно резервирование, пока оно
+	/// не завершено, другие производители не должны помещать сообщения в очередь.
+	/// @param slot - переменная, в которую будет помещен указатель на элемент очереди
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	Result Reserve(T * & slot, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+	/// @brief Опубликовать зарезервированное сообщение
+	/// @details Ставит сообщение, записанное по указателю из Reserve, в конец очереди.
+	/// @return [Результат операции](@ref macs::Result)
+	Result Commit();
+
+	/// @brief Получить доступ к первому сообщению очереди
+	/// @details Получает указатель на сообщение в начале очереди, которое получатель обрабатывает
+	/// без промежуточного копирования. Элемент очереди освобождается вызовом Release. Если очередь пуста,
+	/// задача будет заблокирована до появления сообщения, либо до истечения таймаута. Одновременно 
+	/// допускается только один такой доступ, пока он не завершен, другие получатели не должны извлекать
+	/// сообщения, а производители - ставить их в начало очереди (PushFront).
+	/// @param slot - переменная, в которую будет помещен указатель на сообщение
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	Result Acquire(T * & slot, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+	/// @brief Освободить сообщение, полученное Acquire
+	/// @details Удаляет сообщение из начала очереди, освобождая место для производителей.
+	/// @return [Результат операции](@ref macs::Result)
+	Result Release();
+
+	/// @brief Поставить несколько сообщений в конец очереди
+	/// @details Помещает в очередь столько сообщений, сколько помещается (не более max_qty), с одним 
+	/// обращением к каждому семафору и однократной разблокировкой получателей. Если очередь переполнена,
+	/// задача будет заблокирована до появления свободного места, либо до истечения таймаута.
+	/// @param messages - массив сообщений
+	/// @param max_qty - количество сообщений в массиве
+	/// @param qty - количество помещенных сообщений
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	Result PushN(const T * messages, size_t max_qty, size_t & qty, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+	/// @brief Извлечь несколько сообщений из очереди
+	/// @details Извлекает имеющиеся сообщения (не более max_qty) с одним обращением к каждому семафору 
+	/// и однократной разблокировкой производителей. Если очередь пуста, задача будет заблокирована
+	/// до появления сообщения, либо до истечения таймаута.
+	/// @param messages - массив для сообщений
+	/// @param max_qty - размер массива
+	/// @param qty - количество извлеченных сообщений
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	Result PopN(T * messages, size_t max_qty, size_t & qty, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+#if MACS_WAIT_MULTIPLE
+	/// @brief Получить объект для ожидания сообщений через WaitMultiple
+	/// @details Срабатывание объекта означает наличие сообщения в очереди, само сообщение
+	/// следует извлечь вызовом Pop с нулевым таймаутом.
+	SyncObject * GetReadSync() { return & m_sem_read; }
+#endif
 	 
 private:
 	CLS_COPY(MessageQueue)
@@ -129,15 +203,21 @@ private:
 		QA_PEEK
 	};
 	Result ProcessMessage(Semaphore & wait_sem, Semaphore & sig_sem, T & message, ACTION action, uint32_t timeout_ms);
+	Result CheckCall(uint32_t timeout_ms) const;
+	// Захватывает от 1 до max_qty ресурсов семафора, ожидая только при отсутствии свободных
+	Result WaitN(Semaphore & sem, size_t max_qty, size_t & qty, uint32_t timeout_ms);
+	inline T * Next(T * ptr) const { return ++ ptr == m_memory + m_len ? m_memory : ptr; }
 	
 private:
 	const size_t m_len;
-	Semaphore m_sem_read;
+	MessageQueueSemaphore m_sem_read;
 	Semaphore m_sem_write;
 	
 	bool m_is_alien_mem;
 	T * m_memory;
 	T * m_head_ptr, * m_tail_ptr;	// Любая операция может изменить значение только одного указателя.
+	T * m_reserved;    // элемент, выданный Reserve и еще не опубликованный
+	T * m_acquired;    // элемент, выданный Acquire и еще не освобожденный
 };
 	 
 template <typename T>
@@ -154,6 +234,7 @@ template <typename T>
 		m_is_alien_mem = true;
 	}
 	m_head_ptr = m_tail_ptr = m_memory;
+	m_reserved = m_acquired = nullptr;
 }
 
 template <typename T>
@@ -195,7 +276,7 @@ template <typename T>
 }
 
 template <typename T>
-	Result MessageQueue<T>::ProcessMessage(Semaphore & wait_sem, Semaphore & sig_sem, T & message, ACTION action, uint32_t timeout_ms)
+	Result MessageQueue<T>::CheckCall(uint32_t timeout_ms) const
 {
 	if ( ! Sch().IsInitialized() || ! Sch().IsStarted() ) 
 		return ResultErrorInvalidState;
@@ -207,8 +288,142 @@ template <typename T>
 		if ( System::IsInInterrupt() ) 
 			return ResultErrorInterruptNotSupported;
 	}
+	return ResultOk;
+}
+
+template <typename T>
+	Result MessageQueue<T>::Reserve(T * & slot, uint32_t timeout_ms)
+{
+	Result retcode = CheckCall(timeout_ms);
+	if ( retcode != ResultOk ) 
+		return retcode;
+
+	if ( m_reserved )
+		return ResultErrorInvalidState;
+
+	retcode = m_sem_write.Wait(System::IsInInterrupt() ? 0 : timeout_ms);
+	if ( retcode != ResultOk ) 
+		return retcode;
+
+	// хвост очереди изменяют только производители, поэтому элемент останется за нами до Commit
+	slot = m_reserved = m_tail_ptr;
+	return ResultOk;
+}
+
+template <typename T>
+	Result MessageQueue<T>::Commit()
+{
+	if ( ! m_reserved )
+		return ResultErrorInvalidState;
+	{
+		PauseSection _ps_;
+		_ASSERT(m_reserved == m_tail_ptr);
+		m_tail_ptr = Next(m_tail_ptr);
+		m_reserved = nullptr;
+	}
+	return m_sem_read.Signal();
+}
+
+template <typename T>
+	Result MessageQueue<T>::Acquire(T * & slot, uint32_t timeout_ms)
+{
+	Result retcode = CheckCall(timeout_ms);
+	if ( retcode != ResultOk ) 
+		return retcode;
+
+	if ( m_acquired )
+		return ResultErrorInvalidState;
+
+	retcode = m_sem_read.Wait(System::IsInInterrupt() ? 0 : timeout_ms);
+	if ( retcode != ResultOk ) 
+		return retcode;
+
+	slot = m_acquired = m_head_ptr;
+	return ResultOk;
+}
+
+template <typename T>
+	Result MessageQueue<T>::Release()
+{
+	if ( ! m_acquired )
+		return ResultErrorInvalidState;
+	{
+		PauseSection _ps_;
+		_ASSERT(m_acquired == m_head_ptr);
+		m_head_ptr = Next(m_head_ptr);
+		m_acquired = nullptr;
+	}
+	return m_sem_write.Signal();
+}
+
+template <typename T>
+	Result MessageQueue<T>::WaitN(Semaphore & sem, size_t max_qty, size_t & qty, uint32_t timeout_ms)
+{
+	qty = 0;
+	if ( max_qty == 0 )
+		return ResultErrorInvalidArgs;
+
+	Result retcode = CheckCall(timeout_ms);
+	if ( retcode != ResultOk ) 
+		return retcode;
+
+	// обычно ресурсы есть и достаточно одного обращения к семафору
+	retcode = sem.TryWaitN(max_qty, qty);
+	if ( retcode != ResultOk || qty != 0 )
+		return retcode;
+	if ( ! timeout_ms )
+		return ResultTimeout;
+
+	retcode = sem.Wait(System::IsInInterrupt() ? 0 : timeout_ms);
+	if ( retcode != ResultOk ) 
+		return retcode;
+
+	size_t extra;
+	retcode = sem.TryWaitN(max_qty - 1, extra);
+	qty = 1 + extra;
+	return retcode;
+}
+
+template <typename T>
+	Result MessageQueue<T>::PushN(const T * messages, size_t max_qty, size_t & qty, uint32_t timeout_ms)
+{
+	Result retcode = WaitN(m_sem_write, max_qty, qty, timeout_ms);
+	if ( ! qty ) 
+		return retcode;
+	{
+		PauseSection _ps_;
+		for ( size_t i = 0; i < qty; ++ i ) {
+			* m_tail_ptr = messages[i];
+			m_tail_ptr = Next(m_tail_ptr);
+		}
+	}
+	return m_sem_read.SignalN(qty);
+}
+
+template <typename T>
+	Result MessageQueue<T>::PopN(T * messages, size_t max_qty, size_t & qty, uint32_t timeout_ms)
+{
+	Result retcode = WaitN(m_sem_read, max_qty, qty, timeout_ms);
+	if ( ! qty ) 
+		return retcode;
+	{
+		PauseSection _ps_;
+		for ( size_t i = 0; i < qty; ++ i ) {
+			messages[i] = * m_head_ptr;
+			m_head_ptr = Next(m_head_ptr);
+		}
+	}
+	return m_sem_write.SignalN(qty);
+}
+
+template <typename T>
+	Result MessageQueue<T>::ProcessMessage(Semaphore & wait_sem, Semaphore & sig_sem, T & message, ACTION action, uint32_t timeout_ms)
+{
+	Result retcode = CheckCall(timeout_ms);
+	if ( retcode != ResultOk ) 
+		return retcode;
 
-	Result retcode = wait_sem.Wait(System::IsInInterrupt() ? 0 : timeout_ms);
+	retcode = wait_sem.Wait(System::IsInInterrupt() ? 0 : timeout_ms);
 
 	if ( retcode != ResultOk ) 
 		return retcode;
@@ -58,6 +58,10 @@ public:
 	static Result Lock_Priv(Mutex * mutex, uint32_t timeout_ms); // Только для вызова ядром
 	static Result Unlock_Priv(Mutex * mutex);                    // Только для вызова ядром
 
+#if MACS_WAIT_MULTIPLE
+	virtual bool TryTake(Task * task);
+#endif
+
 private:
 	CLS_COPY(Mutex)
 
@@ -73,22 +77,35 @@ private:
 	{
 		m_owner->RemoveOwnedSync(this);
 #if MACS_MUTEX_PRIORITY_INVERSION
+		return InheritedPriority();
+#endif
+	}
+#if MACS_MUTEX_PRIORITY_INVERSION
+	// Приоритет, который останется у владельца после освобождения мьютекса
+	// (ожидающие этот мьютекс задачи не учитываются).
+	inline Task::Priority InheritedPriority() const
+	{
 		Task::Priority inh_prior = m_owner_original_priority;
-		SyncOwnedObject * pobj = m_owner->m_owned_obj_list;
+		const SyncOwnedObject * pobj = m_owner->m_owned_obj_list;
 		while ( pobj ) {
-			if ( pobj->m_blocked_task_list ) {
+			if ( pobj != this && pobj->m_blocked_task_list ) {
 				Task::Priority prior = pobj->m_blocked_task_list->GetPriority();
 				if ( prior > inh_prior )
 					inh_prior = prior;
 			}
-			pobj = OwnedSyncObjList::Next(pobj);
+			pobj = pobj->m_next_owned_obj;
 		}
 		return inh_prior;
-#endif
 	}
+#endif
 
+	void SetOwner(Task * task);
 	Result UnlockInternal();
 	void UpdateOwnerPriority();
+#if MACS_SYNC_FAST_PATH
+	bool TryLockFast();
+	bool TryUnlockFast();
+#endif
 };
 
 /// @brief Автоматический мьютекс (страж)
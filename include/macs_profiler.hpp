@@ -51,6 +51,7 @@ typedef enum
 	PE_TASK_DEL,
 	
 	PE_IQR_HANDLE,
+	PE_SYS_TICK,
 	
 	PE_EVENT_INIT,
 	PE_EVENT_RAISE,
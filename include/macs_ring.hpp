@@ -0,0 +1,161 @@
+/// @file macs_ring.hpp
+/// @brief Кольцевой буфер "один производитель - один потребитель".
+/// @details Буфер предназначен для потоков данных от обработчиков прерываний к задаче
+/// (прием UART, отсчеты АЦП). Запись и чтение не используют критических секций, паузы
+/// планировщика и обращений к ядру: каждый индекс изменяет только одна сторона, поэтому
+/// обе операции выполняются за ограниченное время из любого контекста. Потребитель может
+/// ожидать данные, а производитель будит его только при достижении заданного порога заполнения
+/// (по умолчанию - при переходе буфера из пустого состояния в непустое).
+/// @copyright AstroSoft Ltd, 2016
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "macs_common.hpp"
+#include "macs_semaphore.hpp"
+
+namespace macs {
+
+/// @brief Шаблон кольцевого буфера "один производитель - один потребитель".
+/// @details Параметры шаблона - тип элемента и емкость буфера (степень двойки). Методы производителя
+/// (Put, Write) должны вызываться только из одного контекста, например, из обработчика прерывания,
+/// методы потребителя (Get, Read, Wait) - только из одной задачи.
+template <typename T, size_t SIZE>
+	class SpscRing
+{
+public:
+	/// @brief Конструктор буфера
+	/// @param threshold - количество элементов, при накоплении которого пробуждается потребитель
+	explicit SpscRing(size_t threshold = 1) :
+		m_head(0),
+		m_tail(0),
+		m_threshold(threshold),
+		m_waiting(false),
+		m_sem(0, 1)
+	{}
+
+	/// @brief Получить емкость буфера
+	static size_t Capacity() { return SIZE; }
+
+	/// @brief Получить количество элементов в буфере
+	size_t Count() const { return m_tail - m_head; }
+
+	/// @brief Получить количество свободных мест в буфере
+	size_t Free() const { return SIZE - Count(); }
+
+	/// @brief Проверка отсутствия элементов в буфере
+	bool IsEmpty() const { return m_tail == m_head; }
+
+	/// @brief Установить порог пробуждения потребителя
+	/// @param threshold - количество элементов, при накоплении которого пробуждается потребитель (от 1 до SIZE)
+	void SetThreshold(size_t threshold) { m_threshold = threshold; }
+
+	/// @brief Поместить элемент в буфер (производитель)
+	/// @param item - элемент
+	/// @return false, если буфер заполнен
+	bool Put(const T & item) { return Write(& item, 1) == 1; }
+
+	/// @brief Поместить несколько элементов в буфер (производитель)
+	/// @details Помещает столько элементов, сколько позволяет свободное место.
+	/// @param items - массив элементов
+	/// @param qty - количество элементов в массиве
+	/// @return Количество помещенных элементов
+	size_t Write(const T * items, size_t qty);
+
+	/// @brief Извлечь элемент из буфера (потребитель)
+	/// @param item - переменная для элемента
+	/// @return false, если буфер пуст
+	bool Get(T & item) { return Read(& item, 1) == 1; }
+
+	/// @brief Извлечь несколько элементов из буфера (потребитель)
+	/// @param items - массив для элементов
+	/// @param max_qty - размер массива
+	/// @return Количество извлеченных элементов
+	size_t Read(T * items, size_t max_qty);
+
+	/// @brief Ждать накопления данных (потребитель)
+	/// @details Блокирует задачу, пока количество элементов в буфере меньше порога пробуждения.
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	Result Wait(uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+private:
+	CLS_COPY(SpscRing)
+
+	typedef char SizeMustBePowerOf2[(SIZE & (SIZE - 1)) == 0 ? 1 : -1];
+	static const uint32_t MASK = SIZE - 1;
+
+	T m_buf[SIZE];
+	volatile uint32_t m_head;     // изменяет только потребитель (индексы не маскируются, а переполняются)
+	volatile uint32_t m_tail;     // изменяет только производитель
+	volatile size_t m_threshold;
+	volatile bool m_waiting;      // потребитель ожидает данных
+	Semaphore m_sem;
+};
+
+template <typename T, size_t SIZE>
+	size_t SpscRing<T, SIZE>::Write(const T * items, size_t qty)
+{
+	const uint32_t tail = m_tail;
+	const size_t count = tail - m_head;
+	if ( qty > SIZE - count )
+		qty = SIZE - count;
+	if ( ! qty )
+		return 0;
+
+	for ( size_t i = 0; i < qty; ++ i )
+		m_buf[(tail + i) & MASK] = items[i];
+	__DMB();	// элементы должны быть записаны до публикации индекса
+	m_tail = tail + qty;
+
+	// потребитель будится только при пересечении порога, а не на каждом элементе
+	const size_t threshold = m_threshold;
+	if ( m_waiting && count < threshold && count + qty >= threshold ) {
+		m_waiting = false;
+		m_sem.Signal();
+	}
+	return qty;
+}
+
+template <typename T, size_t SIZE>
+	size_t SpscRing<T, SIZE>::Read(T * items, size_t max_qty)
+{
+	const uint32_t head = m_head;
+	size_t qty = m_tail - head;
+	if ( qty > max_qty )
+		qty = max_qty;
+	if ( ! qty )
+		return 0;
+
+	__DMB();	// элементы читаются после индекса, по которому они опубликованы
+	for ( size_t i = 0; i < qty; ++ i )
+		items[i] = m_buf[(head + i) & MASK];
+	__DMB();	// место освобождается только после чтения элементов
+	m_head = head + qty;
+	return qty;
+}
+
+template <typename T, size_t SIZE>
+	Result SpscRing<T, SIZE>::Wait(uint32_t timeout_ms)
+{
+	while ( Count() < m_threshold ) {
+		// флаг выставляется до повторной проверки, поэтому производитель, добавивший данные
+		// после нее, увидит флаг и разбудит потребителя
+		m_waiting = true;
+		__DMB();
+		if ( Count() >= m_threshold ) {
+			m_waiting = false;
+			break;
+		}
+
+		Result res = m_sem.Wait(timeout_ms);
+		m_waiting = false;
+		if ( res != ResultOk )
+			return res;
+	}
+	return ResultOk;
+}
+
+}	// namespace macs
@@ -7,10 +7,14 @@
 #include "macs_critical_section.hpp"
 #include "macs_scheduler.hpp"
 #include "macs_event.hpp"
+#include "macs_event_group.hpp"
 #include "macs_mutex.hpp"
 #include "macs_task.hpp"
 #include "macs_semaphore.hpp"
 #include "macs_message_queue.hpp"
+#include "macs_ring.hpp"
+#include "macs_message_buffer.hpp"
+#include "macs_soft_timer.hpp"
 #include "macs_application.hpp"
 #include "macs_profiler.hpp"
 
@@ -48,16 +48,42 @@ public:
 	/// @brief Сигнализировать об открытии семафора
 	/// @details Увеличивает значение счётчика семафора на 1. 
 	/// При этом возможна разблокировка одной из задач, выполнявших для данного семафора метод Wait().
+	/// При вызове из прерывания (MACS_IRQ_POST) операция выполняется отложенно, перед переключением контекста,
+	/// и возвращается ResultOk без проверки счетчика.
 	/// @return [Результат операции](@ref macs::Result)
 	Result Signal();
 
-	static Result Wait_Priv(Semaphore * semaphore, uint32_t timeout_ms); // Только для вызова ядром
-	static Result Signal_Priv(Semaphore * semaphore);                    // Только для вызова ядром
+	/// @brief Захватить несколько ресурсов без ожидания
+	/// @details Уменьшает значение счётчика не более чем на max_qty за одно обращение к ядру.
+	/// @param max_qty - максимальное количество захватываемых ресурсов
+	/// @param qty - количество захваченных ресурсов (может быть 0)
+	/// @return [Результат операции](@ref macs::Result)
+	Result TryWaitN(size_t max_qty, size_t & qty);
+
+	/// @brief Освободить несколько ресурсов
+	/// @details Увеличивает значение счётчика на qty, разблокируя до qty ожидающих задач 
+	/// с однократным перепланированием.
+	/// @param qty - количество освобождаемых ресурсов
+	/// @return [Результат операции](@ref macs::Result)
+	Result SignalN(size_t qty);
+
+	static Result Wait_Priv(Semaphore * semaphore, uint32_t timeout_ms);                 // Только для вызова ядром
+	static Result Signal_Priv(Semaphore * semaphore);                                    // Только для вызова ядром
+	static Result SignalN_Priv(Semaphore * semaphore, size_t qty);                       // Только для вызова ядром
+	static Result TryWaitN_Priv(Semaphore * semaphore, size_t max_qty, size_t * qty);    // Только для вызова ядром
+
+#if MACS_WAIT_MULTIPLE
+	virtual bool TryTake(Task *) { return TryDecrement(); }
+#endif
 	 
 private:
 	CLS_COPY(Semaphore)
 
 	bool TryDecrement() { return m_count ? (-- m_count, true) : false; }
+#if MACS_SYNC_FAST_PATH
+	bool TryDecrementExcl();
+	bool TryIncrementExcl();
+#endif
 
 private:
 	size_t m_count;
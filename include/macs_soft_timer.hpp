@@ -0,0 +1,128 @@
+/// @file macs_soft_timer.hpp
+/// @brief Программные таймеры.
+/// @details Программные таймеры позволяют выполнять действия через заданный интервал времени
+/// (однократно или периодически), не занимая аппаратных таймеров и не создавая отдельной задачи
+/// на каждый таймаут. Все таймеры обслуживаются системным тиком: активные таймеры хранятся
+/// в двоичной куче, упорядоченной по моменту срабатывания, поэтому запуск и остановка таймера
+/// выполняются за O(log n), а проверка на каждом тике - за O(1). Обработчики сработавших таймеров
+/// вызываются задачей таймеров (MACS_SOFT_TIMER_TASK = 1) или непосредственно из обработчика
+/// системного тика (MACS_SOFT_TIMER_TASK = 0).
+/// @copyright AstroSoft Ltd, 2016
+
+#pragma once
+
+#include "macs_scheduler.hpp"
+
+#if MACS_SOFT_TIMERS
+
+namespace macs {
+
+/// @brief Базовый класс программного таймера.
+/// @details Для создания таймера необходимо создать производный класс и переопределить
+/// метод OnTimer(). Объект таймера не должен уничтожаться, пока таймер запущен.
+class SoftTimer
+{
+public:
+	SoftTimer();
+	virtual ~SoftTimer();
+
+	/// @brief Запустить таймер.
+	/// @details Если таймер уже запущен, он перезапускается с новым интервалом.
+	/// Метод можно вызывать из обработчиков прерываний и из обработчиков таймеров.
+	/// @param period_ms - интервал в миллисекундах (не менее одного системного тика)
+	/// @param periodic - true - таймер срабатывает периодически, false - однократно
+	/// @return [Результат операции](@ref macs::Result)
+	Result Start(uint32_t period_ms, bool periodic = false);
+
+	/// @brief Перезапустить таймер.
+	/// @details Отсчет интервала, заданного при последнем запуске, начинается заново.
+	/// @return [Результат операции](@ref macs::Result)
+	Result Reset();
+
+	/// @brief Остановить таймер.
+	/// @details Таймер, срок которого уже наступил, но обработчик которого еще не вызван, не сработает.
+	/// @return [Результат операции](@ref macs::Result)
+	Result Stop();
+
+	/// @brief Проверка активности таймера.
+	/// @return true, если таймер запущен и еще не сработал (для периодического - пока не остановлен).
+	bool IsActive() const { return m_heap_idx >= 0; }
+
+	/// @brief Получить интервал таймера.
+	/// @return Интервал в системных тиках, заданный при последнем запуске.
+	uint32_t GetPeriodTicks() const { return m_period; }
+
+	static Result Start_Priv(SoftTimer * timer, uint32_t period_ticks, bool periodic); // Только для вызова ядром
+	static Result Stop_Priv(SoftTimer * timer);                                        // Только для вызова ядром
+
+protected:
+	/// @brief Обработчик таймера.
+	/// @details Вызывается при срабатывании таймера. Обработчик должен выполняться быстро и не
+	/// блокироваться: при MACS_SOFT_TIMER_TASK = 1 его вызывает общая задача таймеров,
+	/// при MACS_SOFT_TIMER_TASK = 0 - обработчик системного тика.
+	virtual void OnTimer() = 0;
+
+private:
+	CLS_COPY(SoftTimer)
+
+	friend class SoftTimerRoom;
+
+	uint32_t m_expire;     // тик срабатывания
+	uint32_t m_period;     // интервал в тиках
+	int      m_heap_idx;   // позиция в куче таймеров, -1 - таймер не активен
+	bool     m_periodic;
+};
+
+// Очередь активных таймеров - двоичная куча по моменту срабатывания.
+// Все методы, кроме Run, вызываются только в критической секции.
+class SoftTimerRoom
+{
+public:
+	static inline SoftTimerRoom & GetInstance() { return m_instance; }
+
+	bool Insert(SoftTimer * timer);
+	void Remove(SoftTimer * timer);
+
+	// Возвращает очередной сработавший к моменту now таймер (периодический сразу ставится в очередь вновь)
+	SoftTimer * FetchExpired(uint32_t now);
+
+	// Количество тиков до ближайшего срабатывания (0 - есть сработавшие, ULONG_MAX - нет активных)
+	uint32_t TicksToExpire(uint32_t now) const;
+
+	// Вызывается планировщиком на каждом тике
+	void Tick(uint32_t now);
+
+	// Вызывает обработчик сработавшего таймера
+	static inline void Run(SoftTimer * timer) { timer->OnTimer(); }
+
+#if MACS_SOFT_TIMER_TASK
+	Result StartTask();
+#endif
+
+private:
+	SoftTimerRoom();
+	CLS_COPY(SoftTimerRoom)
+
+	static inline bool Preceeding(const SoftTimer * a, const SoftTimer * b) {
+		return static_cast<int32_t>(a->m_expire - b->m_expire) < 0;
+	}
+	static inline bool IsExpired(const SoftTimer * timer, uint32_t now) {
+		return static_cast<int32_t>(now - timer->m_expire) >= 0;
+	}
+
+	inline void Place(SoftTimer * timer, int idx) { m_heap[idx] = timer; timer->m_heap_idx = idx; }
+	void SiftUp(int idx);
+	void SiftDown(int idx);
+
+	static SoftTimerRoom m_instance;
+
+	SoftTimer * m_heap[MACS_SOFT_TIMER_QTY];
+	int m_qty;
+#if MACS_SOFT_TIMER_TASK
+	Task * m_task;
+#endif
+};
+
+}	// namespace macs
+
+#endif
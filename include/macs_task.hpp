@@ -25,6 +25,10 @@ class SyncOwnedObject;
 class Event;
 class Mutex;
 class Semaphore;
+#if MACS_MEM_TASK_ARENA
+class Arena;
+#endif
+struct TaskDesc;
 
 /// @brief Базовый класс для представления задачи.
 /// @details Представляет собой задачу (в "больших" ОС обычно используют термин "поток").
@@ -95,6 +99,16 @@ public:
 		UnblockReasonIrq
 	};
 
+#if MACS_TASK_NOTIFY
+	/// @brief Способы изменения значения уведомления задачи.
+	enum NotifyAction
+	{
+		NotifySetBits,     ///< Установить в значении уведомления указанные биты
+		NotifyIncrement,   ///< Увеличить значение уведомления на 1 (параметр value не используется)
+		NotifyOverwrite    ///< Заменить значение уведомления указанным
+	};
+#endif
+
 	// Используется для выполнения пользовательского кода во время разблокировки задачи ядром.
 	class UnblockFunctor
 	{
@@ -105,6 +119,8 @@ public:
 public:
 	/// @brief Минимальный размер стека в словах.
 	static const size_t MIN_STACK_SIZE = TaskStack::MIN_SIZE;
+	/// @brief Минимальный размер стека задачи, не использующей FPU (см. Task::NoFpu), в словах.
+	static const size_t MIN_NOFPU_STACK_SIZE = TaskStack::MIN_NOFPU_SIZE;
 	/// @brief Размер стека, достаточный для работы небольших задач
 	static const size_t SMALL_STACK_SIZE = (TaskStack::ENOUGH_SIZE + TaskStack::MIN_SIZE) / 2;
 	/// @brief Размер стека, достаточный для работы большинства задач
@@ -120,7 +136,7 @@ public:
 	const char * GetName() const { 		
 #if MACS_TASK_NAME_LENGTH > 0	 
 		return m_name_arr;
-#elif MACS_TASK_NAME_LENGTH == -1	  	
+#elif MACS_TASK_NAME_LENGTH < 0
 		return m_name_ptr;
 #else		
 		return nullptr; 	
@@ -141,6 +157,15 @@ public:
 	/// @param stack_size - размер стека задачи, по умолчанию Task::ENOUGH_STACK_SIZE
 	/// @return [Результат операции](@ref macs::Result)
 	static Result Add(Task * task, Task::Priority priority, Task::Mode mode, size_t stack_size = Task::ENOUGH_STACK_SIZE);
+
+	/// @brief Добавить в планировщик задачи из таблицы.
+	/// @details Таблица описаний задач (@ref macs::TaskDesc) может быть константной и инициализироваться
+	/// при компиляции, а вместе с задачами StaticTask позволяет запустить систему без обращений к динамической памяти.
+	/// Задачи добавляются в порядке следования в таблице, при первой ошибке добавление прекращается.
+	/// @param table - таблица описаний задач
+	/// @param qty - количество элементов таблицы
+	/// @return [Результат операции](@ref macs::Result)
+	static Result AddTable(const TaskDesc * table, size_t qty);
 	
 	/// @brief Добавить задачу в планировщик с возможностью указания всех параметров.
 	/// @details Если планировщик работает в режиме вытесняющей многозадачности, при выполнении 
@@ -260,6 +285,70 @@ public:
     /// часть стека, что может быть необходимо, например, для определения глубины использования
     /// стека при выполнении секции кода.
 	void InstrumentStack() { m_stack.Instrument(); }
+
+	/// @brief Объявить, что задача не использует FPU.
+	/// @details По умолчанию минимальный размер стека включает контекст FPU. Для задачи, объявившей отказ
+	/// от FPU, минимальный размер стека уменьшается до Task::MIN_NOFPU_STACK_SIZE. Метод вызывается до
+	/// добавления задачи в планировщик, обычно в конструкторе пользовательской задачи. Если такая задача
+	/// все же выполнит команду FPU, ядро сигнализирует AR_FPU_UNDECLARED.
+	/// @param on - true, если задача не выполняет команды FPU
+	void NoFpu(bool on = true) { m_no_fpu = on; }
+
+	/// @brief Проверить, выполняла ли задача команды FPU.
+	/// @details Признак устанавливается ядром при первом переключении контекста задачи с расширенным фреймом.
+	/// @return true, если контекст задачи содержит регистры FPU
+	bool IsFpuUsed() const { return m_fpu_used; }
+
+#if MACS_MEM_TASK_ARENA
+	/// @brief Создать арену задачи.
+	/// @details Пока арена включена (см. @ref Task::UseArena), память для операторов new, вызываемых задачей,
+	/// выделяется из арены, а оператор delete для таких блоков ничего не делает. Если арена заполнена,
+	/// память выделяется из кучи. Блоки арены освобождаются все сразу сбросом арены (GetArena()->Reset())
+	/// или до отметки (GetMark/Rewind), а сама арена освобождается при удалении задачи (Task::Delete).
+	/// Объекты, которые должны пережить сброс арены или передаются другим задачам, следует создавать
+	/// при выключенной арене.
+	/// @param size - размер арены в байтах
+	/// @param mem - указатель на внешнюю память для арены. Если не указан, арена размещается в куче.
+	/// @return [Результат операции](@ref macs::Result)
+	Result CreateArena(size_t size, void * mem = nullptr);
+
+	/// @brief Получить арену задачи.
+	/// @return Указатель на арену или nullptr, если арена не создана
+	inline Arena * GetArena() const { return m_arena; }
+
+	/// @brief Включить или выключить выделение памяти операторами new из арены задачи.
+	/// @param on - true, чтобы выделять память из арены
+	/// @return Предыдущее состояние
+	inline bool UseArena(bool on) { const bool prev = m_arena_on; m_arena_on = on; return prev; }
+
+	/// @brief Проверить, выделяется ли память операторами new из арены задачи.
+	inline bool IsArenaUsed() const { return m_arena_on && m_arena; }
+#endif
+
+#if MACS_TASK_NOTIFY
+	/// @brief Отправить уведомление задаче.
+	/// @details Изменяет 32-битное значение уведомления данной задачи и, если задача ожидает 
+	/// уведомления (см. @ref Task::WaitNotify), разблокирует ее. В отличие от событий и семафоров
+	/// не требует отдельного объекта синхронизации. Метод можно вызывать из обработчиков прерываний,
+	/// при MACS_IRQ_POST уведомление из прерывания доставляется отложенно, перед переключением контекста.
+	/// @param value - значение, используемое в соответствии с параметром action
+	/// @param action - [способ изменения значения уведомления](@ref macs::Task::NotifyAction)
+	/// @return [Результат операции](@ref macs::Result)
+	Result Notify(uint32_t value, NotifyAction action = NotifySetBits);
+
+	/// @brief Ждать уведомления текущей задачей.
+	/// @details Если уведомление уже было отправлено, возвращает управление немедленно, иначе блокирует
+	/// текущую задачу до получения уведомления или истечения таймаута. При получении уведомления
+	/// в значении уведомления сбрасываются биты, указанные в clear_mask.
+	/// @param value - значение уведомления на момент получения (до сброса битов)
+	/// @param clear_mask - биты, сбрасываемые в значении уведомления после его получения
+	/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+	/// @return [Результат операции](@ref macs::Result)
+	static Result WaitNotify(uint32_t & value, uint32_t clear_mask = ~0u, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+	static Result Notify_Priv(Task * task, uint32_t value, NotifyAction action);         // Только для вызова ядром
+	static Result WaitNotify_Priv(Task * task, uint32_t clear_mask, uint32_t timeout_ms); // Только для вызова ядром
+#endif
 	 
 protected:
 	/// @brief Конструктор задачи со стеком в динамической памяти.
@@ -293,6 +382,14 @@ private:
 	void InitializeStack(size_t stack_len, void (* onTaskExit)(void));
 
 	bool IsRunnable() const { return m_state == Task::StateRunning || m_state == Task::StateReady; }
+#if MACS_TASK_NOTIFY
+	// Забирает отправленное уведомление (только в критической секции)
+	inline void TakeNotify() {
+		m_notify_recv = m_notify_value;
+		m_notify_value &= ~ m_notify_clear;
+		m_notify_pending = false;
+	}
+#endif
 
 	/// @brief Выполняет задачу.
 	/// @details Реализация рабочих функций задачи. Вызывается ядром. Данный метод должен быть переопределен в
@@ -317,8 +414,10 @@ private:
 	friend class Mutex;
 	friend class Semaphore;
 	friend class Event;
+	friend class EventGroup;
 	friend class TaskRoom;
 	friend class TaskSleepRoom;
+	friend class TaskWorkRoom;
 	friend class TaskIrqRoom;
 	friend Result DeleteTask_Priv(Scheduler * scheduler, Task * task, bool del_mem);
 	friend Result BlockCurrentTask_Priv(Scheduler * scheduler, uint32_t timeout_ms, Task::UnblockFunctor *);
@@ -330,12 +429,11 @@ private:
 #endif
 	friend void _SetTaskPriority_Priv(Scheduler * scheduler, Task * task, Task::Priority priority);
 	friend bool PriorPreceeding(Task * task_a, Task * task_b);
-	friend bool WakeupPreceeding(Task * task_a, Task * task_b);
 	 
 	// имя задачи
 #if MACS_TASK_NAME_LENGTH > 0	 
 	char 				 m_name_arr[MACS_TASK_NAME_LENGTH + 1];
-#elif MACS_TASK_NAME_LENGTH == -1	  	
+#elif MACS_TASK_NAME_LENGTH < 0
 	const char * m_name_ptr;
 #endif	
 
@@ -346,15 +444,26 @@ private:
 	Priority m_priority;
 	State m_state;
 	Mode m_mode;
+	bool m_no_fpu;       // задача объявила отказ от FPU (стек может быть рассчитан без контекста FPU)
+	bool m_fpu_used;     // задача выполняла команды FPU
+	bool m_irq_handler;  // задача зарегистрирована как обработчик прерывания (TaskIrq)
+#if MACS_MEM_TASK_ARENA
+	Arena * m_arena;     // арена задачи, освобождается вместе с задачей
+	bool m_arena_on;     // операторы new выделяют память из арены
+#endif
 	 
 #if MACS_USE_CLOCK
-	Time     m_run_duration;
+	uint64_t m_run_cycles;       // процессорное время задачи в тактах
+	uint64_t m_load_base;        // значение m_run_cycles в начале окна загрузки m_load_seq
+	uint32_t m_load_cycles;      // процессорное время задачи за окно, предшествующее m_load_seq
+	uint32_t m_load_seq;         // номер окна загрузки, к которому отнесено время задачи
 	uint32_t m_switch_cpu_tick;
 #endif	
 	 
-	uint32_t m_dream_ticks;		// на сколько тиков усыпили задачу
+	uint32_t m_dream_ticks;		// на сколько тиков усыпили задачу (в очереди сна - относительно предыдущей задачи)
 public:
 	Task * m_next_sched_task;	// Следующая задача в списке планировщика (work или sleep)
+	Task ** m_sleep_link;		// Указатель, ссылающийся на задачу в очереди сна (nullptr - задача не в очереди сна)
 	Task * m_next_sync_task;	// Следующая заблокированная задача в списке объекта синхронизации
 private:		
 	UnblockFunctor * m_unblock_func;	// содержит функтор, который будет выполнен во время разблокировки задачи ядром
@@ -362,21 +471,29 @@ private:
 
 	// содержит причину последней разблокировки
 	UnblockReason m_unblock_reason;
+
+#if MACS_TASK_NOTIFY
+	uint32_t m_notify_value;    // Текущее значение уведомления
+	uint32_t m_notify_recv;     // Значение, полученное последним вызовом WaitNotify
+	uint32_t m_notify_clear;    // Биты, сбрасываемые при получении уведомления
+	bool m_notify_pending;      // Уведомление отправлено, но еще не получено
+	bool m_notify_waiting;      // Задача заблокирована в ожидании уведомления
+#endif
+
+#if MACS_EVENT_GROUPS
+	uint32_t m_flags_wait;      // Флаги группы событий, которых ожидает задача
+	uint32_t m_flags_recv;      // Значение флагов группы на момент выполнения условия ожидания
+	uint8_t m_flags_options;    // Параметры ожидания (EventGroup::WaitOption)
+#endif
 };
 
 inline bool PriorPreceeding(Task * task_a, Task * task_b)
 {
 	return task_a->m_priority > task_b->m_priority;
 }
-inline bool WakeupPreceeding(Task * task_a, Task * task_b)
-{
-	return task_a->m_dream_ticks <= task_b->m_dream_ticks;
-}
  
 SLISTORD_DECLARE(TaskSyncList, Task, m_next_sync_task, PriorPreceeding);
 SLIST_DECLARE(TaskRoomList, Task, m_next_sched_task);
-SLISTORD_DECLARE(TaskWorkList, Task, m_next_sched_task, PriorPreceeding);
-SLISTORD_DECLARE(TaskSleepList, Task, m_next_sched_task, WakeupPreceeding);
 	
 inline Task::Priority operator + (const Task::Priority prior, const int chg)
 {
@@ -420,6 +537,41 @@ public:
 		(* m_exec_func)(this);
 	}
 };
+
+/// @brief Шаблон задачи со стеком внутри объекта.
+/// @details Стек размещается вместе с объектом задачи, поэтому статический объект StaticTask (вместе со стеком)
+/// располагается компоновщиком в .bss, и при добавлении такой задачи в планировщик динамическая память не используется
+/// (имя задачи также не копируется в кучу при MACS_TASK_NAME_LENGTH, равном -2 или положительному значению).
+/// Параметр шаблона - размер стека в словах. Пользовательская задача наследуется от StaticTask вместо Task:
+/// class Blinker : public StaticTask<256> { ... virtual void Execute(); };
+template <size_t STACK_LEN>
+	class StaticTask : public Task
+{
+protected:
+	/// @brief Конструктор задачи.
+	/// @param name - имя задачи (опционально, может использоваться для отладки)
+	StaticTask(const char * name = nullptr) :
+		Task(STACK_LEN, reinterpret_cast<uint32_t *>(m_stack_mem), name)
+	{}
+
+private:
+	typedef char StackTooSmall[STACK_LEN >= TaskStack::MIN_NOFPU_SIZE ? 1 : -1];
+
+	// uint64_t - для выравнивания стека на 8 байт
+	uint64_t m_stack_mem[(STACK_LEN + 1) / 2];
+};
+
+/// @brief Описание задачи для таблицы задач (см. @ref Task::AddTable).
+/// @details Структура является агрегатом, поэтому таблица описаний может быть константной и полностью
+/// инициализироваться при компиляции:
+/// static const TaskDesc tasks[] = { { & blinker, Task::PriorityNormal, Task::ModeUnprivileged, 0 }, ... };
+struct TaskDesc
+{
+	Task * task;              ///< Задача
+	Task::Priority priority;  ///< Приоритет задачи
+	Task::Mode mode;          ///< Режим выполнения
+	size_t stack_size;        ///< Размер стека в словах для задачи со стеком в куче (0 - Task::ENOUGH_STACK_SIZE), для StaticTask не используется
+};
 	
 /// @brief Класс для задачи, которая служит обработчиком прерывания.
 /// @details Данная задача отличается от обычной тем, что после добавления в планировщик
@@ -524,12 +676,32 @@ private:
 	friend Result AddTaskIrq_Priv(Scheduler * scheduler, TaskIrq * task);
 };
   
+#if MACS_WAIT_MULTIPLE
+class SelectWait;
+
+// Узел ожидания WaitMultiple в списке объекта синхронизации. Узлы принадлежат ожиданию, а не задаче,
+// поэтому одна задача может находиться в списках нескольких объектов одновременно.
+struct SelectNode
+{
+	SelectWait * m_wait;
+	SelectNode * m_next;
+};
+#endif
+
 class SyncObject : public Task::UnblockFunctor 
 {
 public:
 	Task * m_blocked_task_list;
+#if MACS_WAIT_MULTIPLE
+	SelectNode * m_select_list;	// задачи, ожидающие объект через WaitMultiple (по убыванию приоритета)
+#endif
 public:
-	SyncObject() { m_blocked_task_list = nullptr;	}
+	SyncObject() { 
+		m_blocked_task_list = nullptr;
+#if MACS_WAIT_MULTIPLE
+		m_select_list = nullptr;
+#endif
+	}
 		
 	inline bool IsHolding() const { return !! m_blocked_task_list; }
 
@@ -538,9 +710,67 @@ public:
 	virtual void OnUnblockTask(Task *, Task::UnblockReason);
 	virtual void OnDeleteTask(Task *);
 
+#if MACS_WAIT_MULTIPLE
+	inline bool IsSelected() const { return !! m_select_list; }
+
+	// Захватывает объект для задачи, ожидающей его через WaitMultiple (вызывается в критической секции).
+	// Объекты без сигнального состояния (Event) не могут быть захвачены заранее.
+	virtual bool TryTake(Task *) { return false; }
+
+	// Разблокирует задачи, ожидающие объект через WaitMultiple: take - передать задаче объект 
+	// (через TryTake, пока это удается), all - разблокировать все задачи, иначе одну
+	void NotifySelect(bool take, bool all);
+#endif
+
 protected:
 	void DropLinks();
 };
+
+#if MACS_WAIT_MULTIPLE
+// Ожидание WaitMultiple. Размещается в стеке ожидающей задачи и на время ожидания 
+// заменяет для нее объект синхронизации (Task::m_unblock_func).
+class SelectWait : public Task::UnblockFunctor
+{
+public:
+	SelectWait(SyncObject * const objs[], size_t qty) : 
+		m_task(nullptr), m_objs(objs), m_qty(qty), m_fired(-1), m_linked(false) {}
+
+	void Link();
+	void Unlink();
+
+	virtual void OnUnblockTask(Task *, Task::UnblockReason) { Unlink(); }
+	virtual void OnDeleteTask(Task *) { Unlink(); }
+
+	Task * m_task;
+	SyncObject * const * m_objs;
+	size_t m_qty;
+	int m_fired;	// индекс сработавшего объекта, -1 - ни один не сработал
+	bool m_linked;
+	SelectNode m_nodes[MACS_WAIT_MULTIPLE_MAX];
+
+private:
+	CLS_COPY(SelectWait)
+};
+
+/// @brief Ждать любой из нескольких объектов синхронизации.
+/// @details Блокирует текущую задачу до срабатывания одного из объектов или истечения таймаута,
+/// поэтому одна задача может обслуживать несколько источников вместо отдельной задачи на каждый.
+/// Сработавший объект захватывается так же, как при его собственном ожидании: семафор уменьшается
+/// на 1, мьютекс становится принадлежащим задаче (наследование приоритета для ожидающих через
+/// WaitMultiple не выполняется), событие считается полученным. Для очереди сообщений (см. 
+/// MessageQueue::GetReadSync) и группы событий сообщается только о наличии сообщения или 
+/// установленных флагов, их следует получить вызовом с нулевым таймаутом.
+/// Задачи, ожидающие объект собственным методом (Wait, Lock), обслуживаются раньше ожидающих через WaitMultiple.
+/// Объекты не должны уничтожаться во время ожидания.
+/// @param objs - массив объектов (не более MACS_WAIT_MULTIPLE_MAX)
+/// @param qty - количество объектов
+/// @param fired - индекс сработавшего объекта в массиве
+/// @param timeout_ms - таймаут в миллисекундах. Для бесконечного ожидания - macs::INFINITE_TIMEOUT.
+/// @return [Результат операции](@ref macs::Result)
+Result WaitMultiple(SyncObject * const objs[], size_t qty, size_t & fired, uint32_t timeout_ms = INFINITE_TIMEOUT);
+
+extern Result WaitMultiple_Priv(SelectWait * wait, uint32_t timeout_ms);	// Только для вызова ядром
+#endif
  
 class SyncOwnedObject : public SyncObject
 {
@@ -0,0 +1,106 @@
+/// @file macs_trace.hpp
+/// @brief Трассировка ядра.
+/// @details Ядро записывает в кольцевой буфер фиксированного размера события планировщика:
+/// переключения контекста, блокировки и разблокировки задач, входы в прерывания и операции
+/// с объектами синхронизации. Каждая запись занимает 8 байт и содержит метку времени в тактах процессора
+/// (на ядрах M0/M1 - в системных тиках). Запись не выделяет память и не блокируется, поэтому
+/// допустима в любом месте ядра. Содержимое буфера выводится командой терминала TraceTemrCmd
+/// и преобразуется в хронологию событий утилитой tools/macs_trace_decode.py.
+/// Операции мьютекса и семафора трассируются в ядре, поэтому с трассировкой быстрый путь MACS_SYNC_FAST_PATH 
+/// выключен: каждый захват и освобождение идет через SVC и попадает в буфер.
+/// Для использования трассировки необходимо включить опцию MACS_USE_TRACE в настройках системы.
+/// @copyright AstroSoft Ltd, 2016
+
+#pragma once
+
+#include "macs_tunes.h"
+
+#if MACS_USE_TRACE
+
+#include <stdint.h>
+
+namespace macs {
+
+/// @brief Запись трассировки.
+struct TraceRecord
+{
+	uint32_t m_stamp;   ///< Метка времени
+	uint8_t  m_kind;    ///< Тип события (Trace::Kind)
+	uint8_t  m_arg;     ///< Параметр события (приоритет, причина разблокировки)
+	uint16_t m_id;      ///< Идентификатор задачи или объекта (см. Trace::Id), для прерываний - номер прерывания
+};
+
+/// @brief Кольцевой буфер трассировки ядра.
+/// @details Внимание! Рекомендуется пользоваться не методами класса, а макросом MACS_TRACE.
+class Trace
+{
+public:
+	/// @brief Типы событий. При изменении необходимо исправить tools/macs_trace_decode.py.
+	enum Kind
+	{
+		KindNone = 0,
+		KindSwitch,          ///< Переключение на задачу, m_arg - ее приоритет
+		KindBlock,           ///< Блокировка текущей задачи
+		KindUnblock,         ///< Разблокировка задачи, m_arg - Task::UnblockReason
+		KindIrq,             ///< Вход в прерывание
+		KindEventRaise,
+		KindEventWait,
+		KindMutexLock,
+		KindMutexUnlock,
+		KindSemaphoreWait,
+		KindSemaphoreSignal,
+		KindTaskNotify,
+		KindTaskWaitNotify,
+		KindEventGroupSet,
+		KindEventGroupWait
+	};
+
+	/// @brief Записать событие.
+	/// @details Вызывается только из привилегированного режима.
+	static void Put(Kind kind, uint16_t id, uint8_t arg = 0);
+
+	/// @brief Получить компактный идентификатор объекта.
+	/// @details Идентификатор - младшие 16 бит адреса объекта в словах, он уникален в пределах окна памяти 256 Кбайт.
+	static inline uint16_t Id(const void * obj) { return static_cast<uint16_t>(reinterpret_cast<uintptr_t>(obj) >> 2); }
+
+	/// @brief Включить или выключить запись событий.
+	static inline void Enable(bool on) { s_enabled = on; }
+
+	/// @brief Проверить, включена ли запись событий.
+	static inline bool IsEnabled() { return s_enabled; }
+
+	/// @brief Очистить буфер.
+	static void Clear();
+
+	/// @brief Скопировать записи буфера, начиная с самой старой.
+	/// @details На время копирования запись событий следует выключить.
+	/// @param dst - буфер для записей
+	/// @param max_qty - размер буфера в записях
+	/// @return Количество скопированных записей.
+	static uint32_t Read(TraceRecord * dst, uint32_t max_qty);
+
+	/// @brief Получить частоту счетчика меток времени в герцах.
+	static uint32_t GetStampFreq();
+
+private:
+	static uint32_t Reserve(uint32_t & stamp);
+
+	static TraceRecord s_ring[MACS_TRACE_SIZE];
+	static volatile uint32_t s_pos;     // количество записей с момента очистки
+	static volatile bool s_enabled;
+};
+
+}	// namespace macs
+
+	/// @brief Записывает событие трассировки ядра.
+	/// @param kind Тип события без префикса Kind, например Switch.
+	/// @param id Идентификатор задачи или объекта.
+	/// @param arg Параметр события.
+	#define MACS_TRACE(kind, id, arg)  macs::Trace::Put(macs::Trace::Kind##kind, id, arg)
+
+#else
+
+	/// @brief Заглушка. Если трассировка выключена, то обращения к ней заменяются на пустые операторы.
+	#define MACS_TRACE(kind, id, arg)
+
+#endif
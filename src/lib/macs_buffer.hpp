@@ -47,6 +47,10 @@ public:
 	/// @return Размер буфера в байтах.
 	inline size_t Size() const { return m_size; }
 
+	/// @brief Проверить, может ли буфер изменять свой размер.
+	/// @return true - для буфера с динамически изменяемым размером.
+	inline bool IsDynamic() const { return m_state.Check(BS_DYN); }
+
 	/// @brief Получить размер свободной памяти в буфере (в байтах).
 	/// @details Возвращает сумму уже считанных байт в начале буфера и незанятых байт в конце буфера.
 	/// @return Размер свободной памяти в буфере (в байтах).
@@ -5,6 +5,12 @@
 #include <stdlib.h>
 
 #include "macs_log.hpp"
+#include "macs_trace.hpp"
+#include "macs_profiler.hpp"
+#include "macs_memory_manager.hpp"
+#include "macs_scheduler.hpp"
+#include "macs_mutex.hpp"
+#include "macs_semaphore.hpp"
 
 namespace utils {
 
@@ -16,16 +22,293 @@ void HelpTermCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
 		term.WriteLine(PrnFmt("  %s - %s", ZSTR(m_cmds[index].m_name), ZSTR(m_cmds[index].m_cmd->m_comment)));
 }
  
+// Две задачи одного приоритета (выше приоритета терминала) поочередно уступают процессор друг другу,
+// каждый вызов Yield - одно переключение контекста
+class SwitchBenchTask : public Task
+{
+private:
+	ulong m_qty;
+	bool m_fpu;
+public:
+	SwitchBenchTask(ulong qty, bool fpu) : Task("swc"), m_qty(qty), m_fpu(fpu) {}
+private:
+	virtual void Execute()
+	{
+		// команда FPU устанавливает CONTROL.FPCA: дальше контекст задачи сохраняется расширенным фреймом
+		if ( m_fpu ) {
+			volatile float val = 1.0f;
+			val = val * 1.5f;
+		}
+		loop ( ulong, index, m_qty )
+			Task::Yield();
+	}
+};
+
+static uint32_t RunSwitchBench(ulong qty, bool fpu)
+{
+	const Task::Priority prior = Task::GetCurrent()->GetPriority() + 1;
+	SwitchBenchTask first(qty, fpu), second(qty, fpu);
+
+	// вторая задача добавляется раньше, чтобы обе были готовы к выполнению, когда первая начнет уступать процессор
+	const uint32_t start = System::GetCurCpuTick();
+	{
+		PauseSection _ps_;
+		Task::Add(& first, prior, Task::ModePrivileged, Task::SMALL_STACK_SIZE);
+		Task::Add(& second, prior, Task::ModePrivileged, Task::SMALL_STACK_SIZE);
+	}
+	return System::GetCurCpuTick() - start;
+}
+
 ContextSwitchTemrCmd::ContextSwitchTemrCmd() : TermCommand("Измерение времени переключения контекста") {}
 void ContextSwitchTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
 {
-	extern ulong MeasureContextSwitchTime();
-	term.WriteLine("Running...");
-	// Эта функция находится в тестах
-	ulong swc_ns = 0;  // MeasureContextSwitchTime();
-	term.WriteLine(PrnFmt("Context switch (ns): %ld", swc_ns));
+	ulong qty = 1000;
+	bool fpu = false;
+	loop ( uint, index, args.Count() ) {
+		if ( strcmp(args[index], "fpu") == 0 )
+			fpu = true;
+		else if ( atoi(args[index]) > 0 )
+			qty = atoi(args[index]);
+		else {
+			term.WriteLine("Использование: swc [N] [fpu]");
+			return;
+		}
+	}
+
+	// из общего времени вычитается прогон без переключений (создание и удаление задач)
+	const uint32_t overhead = RunSwitchBench(0, fpu);
+	const uint32_t cycles = RunSwitchBench(qty, fpu);
+	const ulong swc = cycles > overhead ? (cycles - overhead) / (2 * qty) : 0;
+	term.WriteLine(PrnFmt("Context switch%s (cycles): %lu (ns): %lu", fpu ? " with FPU context" : "", swc, System::CpuTicksToNs(swc)));
 }
 ContextSwitchTemrCmd g_ctx_swc_tc;
+
+static void TaskBenchIdle(Task *) {}
+
+static volatile uint32_t s_irqlat_stamp;	// такт входа в прерывание
+static volatile bool s_irqlat_armed;		// прерывание вызвано замером, а не стартом обработчиков
+static volatile uint32_t s_irqlat_max;		// наихудшая задержка до начала работы обработчика
+static volatile uint s_irqlat_runs;
+
+// Обработчик прерывания для замера irqlat: назначается в таблице векторов на свободное прерывание
+// вместо MacsIrqHandler
+extern "C" void MacsIrqLatencyHandler()
+{
+	s_irqlat_stamp = System::GetCurCpuTick();
+	s_irqlat_armed = true;
+	MacsIrqHandler();
+}
+
+// Задача-обработчик прерывания: задержка считается от входа в прерывание до начала IrqHandler
+class IrqLatencyTask : public TaskIrq
+{
+public:
+	IrqLatencyTask() : TaskIrq("irqlat") {}
+private:
+	virtual void IrqHandler()
+	{
+		const uint32_t cycles = System::GetCurCpuTick() - s_irqlat_stamp;
+		if ( ! s_irqlat_armed )		// первый вызов при старте задачи
+			return;
+		if ( cycles > s_irqlat_max )
+			s_irqlat_max = cycles;
+		++ s_irqlat_runs;
+	}
+};
+
+static bool RunIrqLatency(Terminal & term, int irq_num, uint handlers, uint reps)
+{
+	const Task::Priority prior = Task::GetCurrent()->GetPriority() + 1;
+	IrqLatencyTask * tasks = new IrqLatencyTask[handlers];
+	bool res = true;
+	loop ( uint, index, handlers ) {
+		if ( TaskIrq::Add(& tasks[index], irq_num, prior, Task::ModePrivileged, Task::SMALL_STACK_SIZE) != ResultOk )
+			res = false;
+	}
+
+	s_irqlat_armed = false;
+	s_irqlat_max = 0;
+	s_irqlat_runs = 0;
+	if ( res ) {
+		// обработчики приоритетнее терминала: к возврату из Delay все они отработали
+		loop ( uint, rep, reps ) {
+			NVIC_SetPendingIRQ((IRQn_Type) irq_num);
+			Task::Delay(1);
+			s_irqlat_armed = false;
+		}
+		res = (s_irqlat_runs == handlers * reps);
+	}
+
+	loop ( uint, index, handlers )
+		tasks[index].Remove();
+	delete [] tasks;
+
+	if ( res )
+		term.WriteLine(PrnFmt("%8u  %6lu  %6lu", handlers, (ulong) s_irqlat_max, System::CpuTicksToNs(s_irqlat_max)));
+	return res;
+}
+
+IrqLatencyTemrCmd::IrqLatencyTemrCmd() : TermCommand("Измерение задержки от прерывания до задачи-обработчика") {}
+void IrqLatencyTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+{
+	if ( args.Count() < 1 || args.Count() > 2 || (args.Count() == 2 && atoi(args[1]) <= 0) ) {
+		term.WriteLine("Использование: irqlat irq_num [N]");
+		term.WriteLine("  вектор свободного прерывания irq_num должен указывать на MacsIrqLatencyHandler");
+		return;
+	}
+	const int irq_num = atoi(args[0]);
+	const uint reps = args.Count() > 1 ? atoi(args[1]) : 100;
+	if ( irq_num < 0 || irq_num >= MACS_IRQ_QTY ) {
+		term.WriteLine("Недопустимый номер прерывания");
+		return;
+	}
+
+	System::SetIrqPriority(irq_num, System::MAX_SYSCALL_INTERRUPT_PRIORITY);
+	NVIC_EnableIRQ((IRQn_Type) irq_num);
+
+	// худший случай за N прерываний: последний в цепочке обработчик начинает работу позже остальных
+	static const uint HANDLERS[] = { 1, 4, 16 };
+	term.WriteLine("Handlers  Max (cycles)  (ns)");
+	loop ( uint, index, countof(HANDLERS) ) {
+		if ( ! RunIrqLatency(term, irq_num, HANDLERS[index], reps) ) {
+			term.WriteLine("Ошибка при выполнении");
+			break;
+		}
+	}
+
+	NVIC_DisableIRQ((IRQn_Type) irq_num);
+}
+IrqLatencyTemrCmd g_irqlat_tc;
+
+WorkRoomBenchTemrCmd::WorkRoomBenchTemrCmd() : TermCommand("Измерение времени переключения контекста при 8, 32 и 128 готовых задачах") {}
+void WorkRoomBenchTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+{
+	if ( args.Count() > 1 || (args.Count() == 1 && atoi(args[0]) <= 0) ) {
+		term.WriteLine("Использование: wbench [N]");
+		return;
+	}
+	const ulong qty = args.Count() ? atoi(args[0]) : 1000;
+
+	// готовые задачи распределяются по уровням ниже приоритета терминала: они находятся в очереди
+	// готовых задач, но не выполняются, пока две задачи swc уступают друг другу процессор
+	const Task::Priority term_prior = Task::GetCurrent()->GetPriority();
+	if ( term_prior <= Task::PriorityIdle + 1 ) {
+		term.WriteLine("Приоритет терминала слишком низкий");
+		return;
+	}
+	const uint levels = term_prior - Task::PriorityIdle - 1;
+
+	static const uint READY[] = { 8, 32, 128 };
+	term.WriteLine("Ready  Switch (cycles)  (ns)");
+	loop ( uint, index, countof(READY) ) {
+		const uint ready = READY[index];
+		TaskNaked ** tasks = new TaskNaked * [ready];
+		uint added = 0;
+		for ( ; added < ready; ++ added ) {
+			tasks[added] = new TaskNaked(TaskBenchIdle, "wbench");
+			tasks[added]->NoFpu();
+			const Task::Priority prior = static_cast<Task::Priority>(Task::PriorityIdle + 1 + added % levels);
+			if ( Task::Add(tasks[added], prior, Task::ModePrivileged, Task::MIN_NOFPU_STACK_SIZE) != ResultOk ) {
+				delete tasks[added];
+				break;
+			}
+		}
+
+		if ( added == ready ) {
+			const uint32_t overhead = RunSwitchBench(0, false);
+			const uint32_t cycles = RunSwitchBench(qty, false);
+			const ulong swc = cycles > overhead ? (cycles - overhead) / (2 * qty) : 0;
+			term.WriteLine(PrnFmt("%5u  %15lu  %4lu", ready, swc, System::CpuTicksToNs(swc)));
+		}
+
+		loop ( uint, task_index, added ) {
+			tasks[task_index]->Remove();
+			delete tasks[task_index];
+		}
+		delete [] tasks;
+
+		if ( added != ready ) {
+			term.WriteLine("Ошибка при выполнении");
+			break;
+		}
+	}
+}
+WorkRoomBenchTemrCmd g_wbench_tc;
+
+// Задача засыпает на время, заведомо большее замера, и остается в списке спящих задач;
+// сроки различаются, чтобы задачи занимали разные места в списке
+static void SysTickBenchSleep(Task *)
+{
+	static uint s_seq = 0;
+	Task::Delay(60000 + s_seq ++);
+}
+
+SysTickBenchTemrCmd::SysTickBenchTemrCmd() : TermCommand("Измерение времени обработчика SysTick при N спящих задачах") {}
+void SysTickBenchTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+{
+	if ( args.Count() > 1 || (args.Count() == 1 && atoi(args[0]) <= 0) ) {
+		term.WriteLine("Использование: stbench [T_ms]");
+		return;
+	}
+#if MACS_PROFILING_ENABLED
+	const uint window_ms = args.Count() ? atoi(args[0]) : 100;
+	const Task::Priority prior = Task::GetCurrent()->GetPriority() + 1;
+
+	// задачи приоритетнее терминала: при добавлении каждая сразу выполняется и засыпает
+	static const uint SLEEPERS[] = { 0, 8, 32, 128 };
+	term.WriteLine("Sleepers  Min (cycles)  Max (cycles)");
+	loop ( uint, index, countof(SLEEPERS) ) {
+		const uint qty = SLEEPERS[index];
+		TaskNaked ** tasks = qty ? new TaskNaked * [qty] : nullptr;
+		uint added = 0;
+		for ( ; added < qty; ++ added ) {
+			tasks[added] = new TaskNaked(SysTickBenchSleep, "stbench");
+			if ( Task::Add(tasks[added], prior, Task::ModePrivileged, Task::MIN_STACK_SIZE) != ResultOk ) {
+				delete tasks[added];
+				break;
+			}
+		}
+
+		if ( added == qty ) {
+			g_prof_data[PE_SYS_TICK].Clear();
+			Task::Delay(window_ms);
+			term.WriteLine(PrnFmt("%8u  %12ld  %12ld", qty, g_prof_data[PE_SYS_TICK].TimeMin(), g_prof_data[PE_SYS_TICK].TimeMax()));
+		}
+
+		loop ( uint, task_index, added ) {
+			tasks[task_index]->Remove();
+			delete tasks[task_index];
+		}
+		delete [] tasks;
+
+		if ( added != qty ) {
+			term.WriteLine("Ошибка при выполнении");
+			break;
+		}
+	}
+#else
+	term.WriteLine("Требуется MACS_PROFILING_ENABLED");
+#endif
+}
+SysTickBenchTemrCmd g_stbench_tc;
+
+MaskedTimeTemrCmd::MaskedTimeTemrCmd() : TermCommand("Наибольшее время маскирования прерываний критической секцией") {}
+void MaskedTimeTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+{
+	if ( args.Count() > 1 || (args.Count() == 1 && strcmp(args[0], "clear") != 0) ) {
+		term.WriteLine("Использование: masked [clear]");
+		return;
+	}
+#if MACS_PROFILING_ENABLED
+	const uint32_t cycles = CriticalSection::GetMaxMasked();
+	term.WriteLine(PrnFmt("Max masked (cycles): %lu (ns): %lu", (ulong) cycles, System::CpuTicksToNs(cycles)));
+	if ( args.Count() )
+		CriticalSection::ClearMaxMasked();
+#else
+	term.WriteLine("Требуется MACS_PROFILING_ENABLED");
+#endif
+}
+MaskedTimeTemrCmd g_masked_tc;
 	
 TickRateTemrCmd::TickRateTemrCmd() : TermCommand("Установка частоты тиков ОС") {}
 void TickRateTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
@@ -42,10 +325,8 @@ void TickRateTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
 }
 TickRateTemrCmd g_tickrate_tc;
 
-TaskListTemrCmd::TaskListTemrCmd() : TermCommand("Получение информации о выполняющихся задачах") {}
-void TaskListTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+static void PrintTaskList(String & str)
 {
-	String str;
 	DynArr<TaskInfo> info;
 	Sch().GetTasksInfo(info);
 	TaskInfo::PrintHeader(str);
@@ -54,10 +335,157 @@ void TaskListTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
 		info[index].Print(str);
 		str.Add("\r\n");
 	}
-	term.WriteLine((CSPTR) str);
+}
+
+#if MACS_MEM_STATISTICS
+static ulong AllocCount()
+{
+	MemoryManager::MemStat stat;
+	MemoryManager::GetStat(stat);
+	ulong count = 0;
+	loop ( size_t, index, MemoryManager::SIZE_HIST_QTY )
+		count += stat.size_hist[index];
+	return count;
+}
+#endif
+
+TaskListTemrCmd::TaskListTemrCmd() : TermCommand("Получение информации о выполняющихся задачах") {}
+void TaskListTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+{
+	if ( args.Count() == 0 ) {
+		String str;
+		PrintTaskList(str);
+		term.WriteLine((CSPTR) str);
+		return;
+	}
+	if ( strcmp(args[0], "bench") != 0 || args.Count() > 2 ) {
+		term.WriteLine("Использование: tlist [bench [N]]");
+		return;
+	}
+
+	// Замер построения таблицы задач без вывода: время в тактах и количество обращений к куче на одно построение
+	// (задача терминала привилегированная, поэтому счетчик тактов доступен)
+	const ulong qty = args.Count() > 1 && atoi(args[1]) > 0 ? atoi(args[1]) : 100;
+	size_t len = 0;
+#if MACS_MEM_STATISTICS
+	const ulong allocs = AllocCount();
+#endif
+	const uint32_t start = System::GetCurCpuTick();
+	loop ( ulong, index, qty ) {
+		String str;
+		PrintTaskList(str);
+		len = str.Len();
+	}
+	const uint32_t cycles = System::GetCurCpuTick() - start;
+
+	term.WriteLine(PrnFmt("Task list: %lu bytes, %lu cycles per build", (ulong) len, (ulong) (cycles / qty)));
+#if MACS_MEM_STATISTICS
+	term.WriteLine(PrnFmt("Heap allocations per build: %lu", (AllocCount() - allocs) / qty));
+#endif
 }
 TaskListTemrCmd g_tlist_tc;
 
+// Замер примитивов синхронизации. Участники - непривилегированные задачи (обращение к ядру идет через SVC),
+// их приоритет выше приоритета терминала, поэтому терминал продолжает работу только после их завершения
+struct SyncBench
+{
+	enum Test { TestMutex, TestSemaphore, TestSvc, TestPingPong };
+
+	Test test;
+	ulong qty;
+	Mutex mutex;
+	Semaphore ping;
+	Semaphore pong;
+	Semaphore empty;
+};
+
+class SyncBenchTask : public Task
+{
+private:
+	SyncBench & m_bench;
+	bool m_pong;
+public:
+	SyncBenchTask(SyncBench & bench, bool pong) : Task("sbench"), m_bench(bench), m_pong(pong) {}
+private:
+	virtual void Execute();
+};
+
+void SyncBenchTask::Execute()
+{
+	SyncBench & b = m_bench;
+	switch ( b.test ) {
+	case SyncBench::TestMutex:
+		loop ( ulong, index, b.qty ) {
+			b.mutex.Lock();
+			b.mutex.Unlock();
+		}
+		break;
+	case SyncBench::TestSemaphore:
+		loop ( ulong, index, b.qty ) {
+			b.ping.Signal();
+			b.ping.Wait();
+		}
+		break;
+	case SyncBench::TestSvc:
+		// на пустом семафоре быстрый путь не проходит: каждый вызов - SVC и возврат по таймауту
+		loop ( ulong, index, b.qty )
+			b.empty.Wait(0);
+		break;
+	case SyncBench::TestPingPong:
+		loop ( ulong, index, b.qty ) {
+			if ( m_pong ) {
+				b.ping.Wait();
+				b.pong.Signal();
+			} else {
+				b.ping.Signal();
+				b.pong.Wait();
+			}
+		}
+		break;
+	}
+}
+
+static uint32_t RunSyncBench(SyncBench & bench, ulong qty)
+{
+	bench.qty = qty;
+	const Task::Priority prior = Task::GetCurrent()->GetPriority() + 1;
+	SyncBenchTask ping(bench, false), pong(bench, true);
+
+	const uint32_t start = System::GetCurCpuTick();
+	Task::Add(& ping, prior, Task::ModeUnprivileged, Task::SMALL_STACK_SIZE);
+	if ( bench.test == SyncBench::TestPingPong )
+		Task::Add(& pong, prior, Task::ModeUnprivileged, Task::SMALL_STACK_SIZE);
+	return System::GetCurCpuTick() - start;
+}
+
+// Такты на одну итерацию теста: из общего времени вычитается прогон без итераций (создание и удаление задач)
+static ulong SyncBenchCycles(SyncBench & bench, SyncBench::Test test, ulong qty)
+{
+	bench.test = test;
+	const uint32_t overhead = RunSyncBench(bench, 0);
+	const uint32_t cycles = RunSyncBench(bench, qty);
+	return cycles > overhead ? (cycles - overhead) / qty : 0;
+}
+
+SyncBenchTemrCmd::SyncBenchTemrCmd() : TermCommand("Измерение времени захвата и освобождения мьютекса и семафора") {}
+void SyncBenchTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+{
+	if ( args.Count() > 1 || (args.Count() == 1 && atoi(args[0]) <= 0) ) {
+		term.WriteLine("Использование: sbench [N]");
+		return;
+	}
+	const ulong qty = args.Count() ? atoi(args[0]) : 1000;
+
+	SyncBench * bench = new SyncBench;
+	term.WriteLine(PrnFmt("Fast path (MACS_SYNC_FAST_PATH): %s", MACS_SYNC_FAST_PATH ? "on" : "off"));
+	term.WriteLine(PrnFmt("Mutex Lock+Unlock (cycles): %lu", SyncBenchCycles(* bench, SyncBench::TestMutex, qty)));
+	term.WriteLine(PrnFmt("Semaphore Signal+Wait (cycles): %lu", SyncBenchCycles(* bench, SyncBench::TestSemaphore, qty)));
+	term.WriteLine(PrnFmt("SVC Wait(0) on empty semaphore (cycles): %lu", SyncBenchCycles(* bench, SyncBench::TestSvc, qty)));
+	term.WriteLine(PrnFmt("Ping-pong round trip (cycles): %lu", SyncBenchCycles(* bench, SyncBench::TestPingPong, qty)));
+	delete bench;
+}
+SyncBenchTemrCmd g_sbench_tc;
+
 #if MACS_USE_LOG
 SysLogTemrCmd::SysLogTemrCmd() : TermCommand("Просмотр системного журнала") {}
 void SysLogTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
@@ -69,6 +497,135 @@ void SysLogTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
 SysLogTemrCmd g_syslog_tc;
 #endif
 
+#if MACS_USE_TRACE
+TraceTemrCmd::TraceTemrCmd() : TermCommand("Трассировка ядра") {}
+void TraceTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+{
+	if ( args.Count() == 1 ) {
+		if ( strcmp(args[0], "on") == 0 )
+			Trace::Enable(true);
+		else if ( strcmp(args[0], "off") == 0 )
+			Trace::Enable(false);
+		else if ( strcmp(args[0], "clear") == 0 )
+			Trace::Clear();
+		else
+			term.WriteLine("Использование: trace [on|off|clear]");
+		return;
+	}
+
+	// Формат вывода: заголовок, таблица имен задач, записи от старой к новой
+	const bool enabled = Trace::IsEnabled();
+	Trace::Enable(false);
+
+	TraceRecord * recs = new TraceRecord[MACS_TRACE_SIZE];
+	const uint32_t qty = Trace::Read(recs, MACS_TRACE_SIZE);
+
+	const uint tqty = Sch().GetTasksQty();
+	Task ** tasks = new Task * [tqty];
+	const uint tcnt = Sch().GetTasks(tasks, tqty);
+
+	Trace::Enable(enabled);
+
+	term.WriteLine(PrnFmt("MACS-TRACE 1 %lu", (ulong) Trace::GetStampFreq()));
+	loop ( uint, index, tcnt ) {
+		CSPTR name = tasks[index]->GetName();
+		term.WriteLine(PrnFmt("T %04x %s", Trace::Id(tasks[index]), name ? name : "?"));
+	}
+	loop ( uint32_t, index, qty )
+		term.WriteLine(PrnFmt("R %08lx %02x %02x %04x", (ulong) recs[index].m_stamp, recs[index].m_kind, recs[index].m_arg, recs[index].m_id));
+	term.WriteLine("END");
+
+	delete [] tasks;
+	delete [] recs;
+}
+TraceTemrCmd g_trace_tc;
+#endif
+
+#if MACS_MEM_STATISTICS
+MemStatTemrCmd::MemStatTemrCmd() : TermCommand("Статистика динамической памяти") {}
+void MemStatTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+{
+	if ( args.Count() == 1 && strcmp(args[0], "reset") == 0 ) {
+		MemoryManager::ResetStat();
+		return;
+	}
+	if ( args.Count() != 0 ) {
+		term.WriteLine("Использование: mem [reset]");
+		return;
+	}
+
+	MemoryManager::MemStat stat;
+	MemoryManager::GetStat(stat);
+
+	term.WriteLine(PrnFmt("Heap: %lu used: %lu peak: %lu", (ulong) stat.heap_size, (ulong) stat.cur_size, (ulong) stat.peak_size));
+#if MACS_MEM_SIZE_CLASSES
+	term.WriteLine(PrnFmt("Class pools: %lu (not returned to heap)", (ulong) stat.pool_size));
+#endif
+	term.WriteLine(PrnFmt("Free: %lu blocks: %lu largest: %lu", (ulong) stat.free_size, (ulong) stat.free_blocks, (ulong) stat.largest_free));
+	term.WriteLine(PrnFmt("Out of memory: %lu", (ulong) stat.oom_retries));
+	term.WriteLine(PrnFmt("Alloc (cycles): min %lu avg %lu max %lu n %lu", (ulong) stat.alloc_latency.min, (ulong) stat.alloc_latency.Avg(),
+	                      (ulong) stat.alloc_latency.max, (ulong) stat.alloc_latency.count));
+	term.WriteLine(PrnFmt("Free (cycles): min %lu avg %lu max %lu n %lu", (ulong) stat.free_latency.min, (ulong) stat.free_latency.Avg(),
+	                      (ulong) stat.free_latency.max, (ulong) stat.free_latency.count));
+	term.WriteLine("Sizes:");
+	loop ( size_t, index, MemoryManager::SIZE_HIST_QTY ) {
+		if ( index + 1 < MemoryManager::SIZE_HIST_QTY )
+			term.WriteLine(PrnFmt("  <= %4lu: %lu", 16ul << index, (ulong) stat.size_hist[index]));
+		else
+			term.WriteLine(PrnFmt("  >  %4lu: %lu", 16ul << (index - 1), (ulong) stat.size_hist[index]));
+	}
+#if MACS_MEM_SIZE_CLASSES
+	term.WriteLine("Classes:");
+	loop ( size_t, index, MemoryManager::SizeClassQty() ) {
+		MemoryManager::SizeClassInfo info;
+		MemoryManager::GetSizeClassInfo(index, info);
+		term.WriteLine(PrnFmt("  %3lu: hits %lu misses %lu blocks %lu free %lu", (ulong) info.block_size, (ulong) info.hits,
+		                      (ulong) info.misses, (ulong) info.blocks_total, (ulong) info.blocks_free));
+	}
+#endif
+}
+MemStatTemrCmd g_memstat_tc;
+#endif
+
+#if MACS_MEM_PROFILE
+MemProfTemrCmd::MemProfTemrCmd() : TermCommand("Места вызова, выделяющие динамическую память") {}
+void MemProfTemrCmd::DoAction(Terminal & term, const DynArr<CSPTR> & args)
+{
+	size_t top = 10;
+	bool by_allocs = false;
+	loop ( uint, index, args.Count() ) {
+		if ( strcmp(args[index], "reset") == 0 ) {
+			MemoryManager::ResetProfile();
+			return;
+		}
+		if ( strcmp(args[index], "allocs") == 0 )
+			by_allocs = true;
+		else if ( atoi(args[index]) > 0 )
+			top = MIN((size_t) atoi(args[index]), (size_t) MACS_MEM_PROFILE_SITES);
+		else {
+			term.WriteLine("Использование: mprof [N] [allocs] | mprof reset");
+			return;
+		}
+	}
+
+	// адреса мест вызова сопоставляются с исходным текстом по map-файлу или addr2line
+	MemoryManager::ProfileSite * sites = new MemoryManager::ProfileSite[top];
+	const size_t qty = MemoryManager::GetProfile(sites, top, by_allocs);
+
+	term.WriteLine("Site        Blocks   Bytes    Allocs");
+	loop ( size_t, index, qty ) {
+		const MemoryManager::ProfileSite & ps = sites[index];
+		if ( ps.site )
+			term.WriteLine(PrnFmt("0x%08lx  %-8lu %-8lu %lu", (ulong) ps.site, (ulong) ps.blocks, (ulong) ps.bytes, (ulong) ps.allocs));
+		else
+			term.WriteLine(PrnFmt("other       %-8lu %-8lu %lu", (ulong) ps.blocks, (ulong) ps.bytes, (ulong) ps.allocs));
+	}
+
+	delete [] sites;
+}
+MemProfTemrCmd g_memprof_tc;
+#endif
+
 }	// namespace utils
  
 #endif	// #if MACS_USE_TERMINAL
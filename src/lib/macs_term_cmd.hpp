@@ -23,6 +23,44 @@ public:
 };
 extern ContextSwitchTemrCmd g_ctx_swc_tc;
 
+// Наихудшая задержка от входа в прерывание до начала работы задачи-обработчика TaskIrq для 1, 4 и 16 обработчиков
+class IrqLatencyTemrCmd : public TermCommand
+{
+public:
+	IrqLatencyTemrCmd();
+	virtual void DoAction(Terminal & term, const DynArr<CSPTR> & args);
+};
+extern IrqLatencyTemrCmd g_irqlat_tc;
+
+extern "C" void MacsIrqLatencyHandler();
+
+// Время переключения контекста (Yield) при 8, 32 и 128 готовых задачах разных приоритетов
+class WorkRoomBenchTemrCmd : public TermCommand
+{
+public:
+	WorkRoomBenchTemrCmd();
+	virtual void DoAction(Terminal & term, const DynArr<CSPTR> & args);
+};
+extern WorkRoomBenchTemrCmd g_wbench_tc;
+
+// Время обработчика SysTick (минимум и максимум) для разного числа задач в списке спящих (требует MACS_PROFILING_ENABLED)
+class SysTickBenchTemrCmd : public TermCommand
+{
+public:
+	SysTickBenchTemrCmd();
+	virtual void DoAction(Terminal & term, const DynArr<CSPTR> & args);
+};
+extern SysTickBenchTemrCmd g_stbench_tc;
+
+// Наибольшее время маскирования прерываний (BASEPRI) критической секцией с момента сброса (требует MACS_PROFILING_ENABLED)
+class MaskedTimeTemrCmd : public TermCommand
+{
+public:
+	MaskedTimeTemrCmd();
+	virtual void DoAction(Terminal & term, const DynArr<CSPTR> & args);
+};
+extern MaskedTimeTemrCmd g_masked_tc;
+
 class TickRateTemrCmd : public TermCommand
 {
 public:
@@ -39,6 +77,15 @@ public:
 };
 extern TaskListTemrCmd g_tlist_tc;
 
+// Время операций мьютекса и семафора из непривилегированной задачи: быстрый путь, SVC, пинг-понг двух задач
+class SyncBenchTemrCmd : public TermCommand
+{
+public:
+	SyncBenchTemrCmd();
+	virtual void DoAction(Terminal & term, const DynArr<CSPTR> & args);
+};
+extern SyncBenchTemrCmd g_sbench_tc;
+
 #if MACS_USE_LOG
 class SysLogTemrCmd : public TermCommand
 {
@@ -49,6 +96,38 @@ public:
 extern SysLogTemrCmd g_syslog_tc;
 #endif
 
+#if MACS_USE_TRACE
+// Вывод буфера трассировки ядра в текстовом виде для утилиты tools/macs_trace_decode.py
+class TraceTemrCmd : public TermCommand
+{
+public:
+	TraceTemrCmd();
+	virtual void DoAction(Terminal & term, const DynArr<CSPTR> & args);
+};
+extern TraceTemrCmd g_trace_tc;
+#endif
+
+#if MACS_MEM_STATISTICS
+// Статистика распределителя памяти: фрагментация, размеры запросов, время выполнения
+class MemStatTemrCmd : public TermCommand
+{
+public:
+	MemStatTemrCmd();
+	virtual void DoAction(Terminal & term, const DynArr<CSPTR> & args);
+};
+extern MemStatTemrCmd g_memstat_tc;
+#endif
+
+#if MACS_MEM_PROFILE
+// Профиль динамической памяти: живые блоки и количество выделений по местам вызова
+class MemProfTemrCmd : public TermCommand
+{
+public:
+	MemProfTemrCmd();
+	virtual void DoAction(Terminal & term, const DynArr<CSPTR> & args);
+};
+extern MemProfTemrCmd g_memprof_tc;
+#endif
 
 } //  namespace utils
 using namespace utils;
@@ -93,23 +93,51 @@ PrnFmt::~PrnFmt()
 CSPTR const g_zstr = ""; 
 CSPTR const String::NEWLINE = "\r\n"; 
  
+void String::Realloc(size_t cap)
+{
+	char * new_str = new char[cap + 1];
+	memcpy(new_str, m_str, m_len + 1);
+	if ( ! IsInline() )
+		delete[] m_str;
+	m_str = new_str;
+	m_cap = cap;
+}
+
 String & String::Add(CSPTR ptr, size_t len)
 {
 	if ( len ) {
 		_ASSERT(ptr);	
-		size_t old_len = Len();
-		char * new_str = new char[old_len + len + 1];
-		if ( old_len ) 
-			memcpy(new_str, m_str, old_len);
-		memcpy(new_str + old_len, ptr, len);
-		new_str[old_len + len] = '\0';
-		if ( m_str )
-			delete[] m_str;
-		m_str = new_str;
+		const size_t new_len = m_len + len;
+		if ( new_len > m_cap ) {
+			// добавляемая часть может находиться в самой строке
+			const bool is_own = ptr >= m_str && ptr < m_str + m_len;
+			const size_t offs = ptr - m_str;
+			Realloc(MAX(2 * m_cap, new_len));
+			if ( is_own )
+				ptr = m_str + offs;
+		}
+		memcpy(m_str + m_len, ptr, len);
+		m_len = new_len;
+		m_str[m_len] = '\0';
 	}
 	return * this;
 }
 
+String & String::Assign(CSPTR ptr, size_t len)
+{
+	if ( ptr >= m_str && ptr <= m_str + m_len ) {
+		// присваивание части самой строки
+		_ASSERT(ptr + len <= m_str + m_len);
+		memmove(m_str, ptr, len);
+		m_len = len;
+		m_str[m_len] = '\0';
+		return * this;
+	}
+	m_len = 0;
+	m_str[0] = '\0';
+	return Add(ptr, len);
+}
+
 CRC32 g_crc32;
 
 CRC32::CRC32()
@@ -174,7 +202,7 @@ bool TaskStack::Check()
 	return true;
 }
 
-void TaskStack::Build(size_t len, uint32_t * mem)
+void TaskStack::Build(size_t len, uint32_t * mem, size_t min_len)
 {
 	Free();
 		
@@ -183,12 +211,12 @@ void TaskStack::Build(size_t len, uint32_t * mem)
 #if MACS_MPU_PROTECT_STACK		
 									= GUARD_SIZE;
 #else		
-									= (len > MIN_SIZE ? GUARD_SIZE : 0);
+									= (len > min_len ? GUARD_SIZE : 0);
 #endif
 		m_is_alien_mem = mem;
 		m_memory = mem;
 
-		BuildPlatformSpecific(guard, len);
+		BuildPlatformSpecific(guard, len, min_len);
 
 #if	MACS_WATCH_STACK
 		m_top.Instrument(m_margin, true);
@@ -198,10 +226,10 @@ void TaskStack::Build(size_t len, uint32_t * mem)
 	}	
 }
 
-void TaskStack::Prepare(size_t len, void * this_ptr, void (* run_func)(void), void (* exit_func)(void))
+void TaskStack::Prepare(size_t len, void * this_ptr, void (* run_func)(void), void (* exit_func)(void), size_t min_len)
 {
 	if ( ! m_memory )
-		Build(len);
+		Build(len, nullptr, min_len);
 
 	PreparePlatformSpecific(len, this_ptr, run_func, exit_func);
 }
@@ -221,6 +249,17 @@ namespace macs {
 	
 StackPtr SchedulerSwitchContext(StackPtr new_sp)
 {
+#if MACS_IRQ_POST
+	// Операции, отложенные прерываниями, выполняются до выбора следующей задачи, каждая - в своей 
+	// критической секции. Запросы переключения, выданные ими, избыточны и снимаются. Очередь 
+	// проверяется повторно, чтобы не снять запрос прерывания, записавшего вызов после ее обхода.
+	Scheduler & sch = Sch();
+	while ( sch.m_irq_posts.Drain() ) {
+		System::CancelSwitchContext();
+		if ( sch.m_irq_posts.IsEmpty() )
+			break;
+	}
+#endif
 	return Sch().SwitchContext(new_sp);
 }
 
@@ -48,6 +48,24 @@ enum EPrivilegedMethods
 	EPM_Mutex_Unlock_Priv,
 	EPM_Semaphore_Wait_Priv,
 	EPM_Semaphore_Signal_Priv,
+	EPM_Semaphore_SignalN_Priv,
+	EPM_Semaphore_TryWaitN_Priv,
+#if MACS_TASK_NOTIFY
+	EPM_Task_Notify_Priv,
+	EPM_Task_WaitNotify_Priv,
+#endif
+#if MACS_SOFT_TIMERS
+	EPM_SoftTimer_Start_Priv,
+	EPM_SoftTimer_Stop_Priv,
+#endif
+#if MACS_EVENT_GROUPS
+	EPM_EventGroup_Set_Priv,
+	EPM_EventGroup_Clear_Priv,
+	EPM_EventGroup_Wait_Priv,
+#endif
+#if MACS_WAIT_MULTIPLE
+	EPM_WaitMultiple_Priv,
+#endif
 	EPM_SpiTransferCore_Initialize_Priv,
 	EPM_Spi_PowerControl_Priv,
 
@@ -94,6 +112,7 @@ typedef enum
 	AR_BLOCKING_MUTEX_DESTR,  ///< Мьютекс, блокировавший одну или несколько задач, удалён	
     AR_PRIV_TASK_ADDING,
 	AR_NO_GRAPH_GUARD,				///< Попытка выполнить операцию рисования без использования GraphGuard
+	AR_FPU_UNDECLARED,        ///< Задача, объявившая отказ от FPU (см. Task::NoFpu), выполнила команду FPU, а ее стек рассчитан без контекста FPU
 	 
 	AR_UNKNOWN                ///< Неизвестная ошибка
 } ALARM_REASON;
@@ -257,15 +276,29 @@ extern void Sprintf(char * buf, size_t bufsz, CSPTR format, ...);
  
 extern CSPTR const g_zstr; 
 inline CSPTR ZSTR(CSPTR str) { return str ? str : g_zstr; }
+/// @brief Строка с динамическим размером.
+/// @details Строка хранит свою длину и емкость, поэтому Len() и добавление не просматривают ее содержимое,
+/// а при нехватке места емкость увеличивается вдвое: построение строки последовательными Add копирует каждый
+/// символ в среднем O(1) раз. Строки до INLINE_LEN символов хранятся внутри объекта, без обращения к куче.
+/// Пустая строка, как и прежде, приводится к nullptr.
 class String
 {
 public:	
 	static CSPTR const NEWLINE; 
 private:	
-	char * m_str;
+	static const size_t INLINE_LEN = 15;   // длина строки, хранимой внутри объекта
+
+	char * m_str;                   // m_buf или блок в динамической памяти
+	size_t m_len;
+	size_t m_cap;                   // емкость без завершающего нуля
+	char   m_buf[INLINE_LEN + 1];
+
+	inline void Init() { m_str = m_buf; m_len = 0; m_cap = INLINE_LEN; m_buf[0] = '\0'; }
+	inline bool IsInline() const { return m_str == m_buf; }
+	void Realloc(size_t cap);
 public:	
 	String(CSPTR str = nullptr, int len = -1) { 
-		m_str = nullptr; 
+		Init(); 
 		if ( str ) {
 			if ( len == -1 )
 				len = strlen(str);
@@ -274,39 +307,54 @@ public:
 			Add(str, len); 
 		}
 	}
+	String(const String & str) { Init(); Add(str.m_str, str.m_len); }
  ~String() { Clear(); }
-	String & operator = (const String & str) { return (* this) = (CSPTR) str; }
-	String & operator = (CSPTR str) { Clear(); Add(str); return * this; }
-	bool operator ! () const { return ! m_str; }
-	inline size_t Len() const { return m_str ? strlen(m_str) : 0; }
+	String & operator = (const String & str) { return Assign(str.m_str, str.m_len); }
+	String & operator = (CSPTR str) { return Assign(str, str ? strlen(str) : 0); }
+	bool operator ! () const { return ! m_len; }
+	inline size_t Len() const { return m_len; }
+	inline size_t Capacity() const { return m_cap; }
 	inline String & Clear() { 
-		if ( m_str ) 
+		if ( ! IsInline() ) 
 			delete[] m_str; 
-		m_str = nullptr; 
+		Init(); 
 		return * this; 
 	}
+	/// @brief Зарезервировать память для строки длиной cap символов
+	inline String & Reserve(size_t cap) {
+		if ( cap > m_cap )
+			Realloc(cap);
+		return * this;
+	}
+	/// @brief Заменить содержимое строки (занятая память сохраняется)
+	String & Assign(CSPTR ptr, size_t len);
 	inline String & Add(CSPTR str) {
 		if ( str ) 
 			Add(str, strlen(str));		 
 		return * this;
 	}
 	inline String & Add(char c) {
-		char buf[2]; buf[0] = c; buf[1] = '\0';
-		return Add(buf);		 
+		if ( ! c )
+			return * this;
+		if ( m_len == m_cap )
+			Realloc(2 * m_cap);
+		m_str[m_len ++] = c;
+		m_str[m_len] = '\0';
+		return * this;
 	}
 	inline String & NewLine() { return Add(NEWLINE); }
 	inline String & operator << (CSPTR str) { return Add(str); }
 	inline String & operator << (char c) { return Add(c); }
 	String & Add(CSPTR ptr, size_t len);
-	inline operator CSPTR() const { return m_str; }		
+	inline operator CSPTR() const { return m_len ? m_str : nullptr; }		
 	CSPTR Z() const { return ZSTR((CSPTR) * this); }
 	inline bool operator == (CSPTR str) const {
-		if ( ! m_str ) return ! str;
-		if ( ! str ) return ! m_str;
+		if ( ! m_len ) return ! str;
+		if ( ! str ) return false;
 		return ! strcmp(m_str, str); 
 	}
 	inline int FindAnyChr(CSPTR chrs) {
-		if ( ! m_str || ! chrs )
+		if ( ! m_len || ! chrs )
 			return -1;
 		CSPTR p = strpbrk(m_str, chrs);
 		return p ? (p - m_str) : -1;
@@ -18,8 +18,11 @@
 #include "macs_mutex.hpp"
 #include "macs_semaphore.hpp"
 #include "macs_event.hpp"
+#include "macs_event_group.hpp"
+#include "macs_soft_timer.hpp"
 #include "macs_list.hpp"
 #include "macs_profiler.hpp"
+#include "macs_trace.hpp"
 #if MACS_USE_LOG
 	#include "macs_log.hpp"
 #endif	
@@ -43,7 +46,29 @@ extern "C" void * svcMethods[] =
 	reinterpret_cast<void *>(& Mutex::Lock_Priv),
 	reinterpret_cast<void *>(& Mutex::Unlock_Priv),
 	reinterpret_cast<void *>(& Semaphore::Wait_Priv), 
-	reinterpret_cast<void *>(& Semaphore::Signal_Priv)
+	reinterpret_cast<void *>(& Semaphore::Signal_Priv),
+	reinterpret_cast<void *>(& Semaphore::SignalN_Priv),
+	reinterpret_cast<void *>(& Semaphore::TryWaitN_Priv)
+#if MACS_TASK_NOTIFY
+	,
+	reinterpret_cast<void *>(& Task::Notify_Priv),
+	reinterpret_cast<void *>(& Task::WaitNotify_Priv)
+#endif
+#if MACS_SOFT_TIMERS
+	,
+	reinterpret_cast<void *>(& SoftTimer::Start_Priv),
+	reinterpret_cast<void *>(& SoftTimer::Stop_Priv)
+#endif
+#if MACS_EVENT_GROUPS
+	,
+	reinterpret_cast<void *>(& EventGroup::Set_Priv),
+	reinterpret_cast<void *>(& EventGroup::Clear_Priv),
+	reinterpret_cast<void *>(& EventGroup::Wait_Priv)
+#endif
+#if MACS_WAIT_MULTIPLE
+	,
+	reinterpret_cast<void *>(& WaitMultiple_Priv)
+#endif
 #if MACS_SHARED_MEM_SPI			
 	,
 	reinterpret_cast<void *>(& Spi_Initialize_Priv),
@@ -56,15 +81,22 @@ extern "C" void SvcInitScheduler();
 #if MACS_DEBUG	
 unsigned long IdleTaskCnt; // Глобальная переменная для отладки
 #endif	
-class IdleTask : public Task
+#if MACS_STATIC_SYS_TASKS
+typedef StaticTask<Task::MIN_NOFPU_STACK_SIZE> IdleTaskBase;	// задача бездействия не использует FPU (NoFpu)
+#else
+typedef Task IdleTaskBase;
+#endif
+class IdleTask : public IdleTaskBase
 {
 public:
-	IdleTask() : Task("IDLE") { }
+	IdleTask() : IdleTaskBase("IDLE") { NoFpu(); }
 
 private:	
 	virtual void Execute() { 
 		for(;;) {
-#if MACS_SLEEP_ON_IDLE
+#if MACS_TICKLESS_IDLE
+			Sch().TicklessIdle();
+#elif MACS_SLEEP_ON_IDLE
 			System::EnterSleepMode();
 #endif			
 #if MACS_DEBUG	
@@ -83,6 +115,13 @@ Scheduler::Scheduler() :
 	m_pause_cnt(0),
 	m_pending_swc(false),
 	m_use_preemption(true)
+#if MACS_USE_CLOCK
+	,
+	m_load_ticks(0),
+	m_load_start(0),
+	m_load_window(0),
+	m_load_seq(0)
+#endif
 {}
 Scheduler Scheduler::m_instance;
 
@@ -119,7 +158,16 @@ Result Scheduler::Initialize()
 	// поэтому в данном случае управление будет передано задаче бездействие;
 	// у неё самый низкий приоритет, поэтому, если есть какая-либо другая задача 
 	// более высокого приоритета, то IdleTask не получит процессорного времени
+#if MACS_STATIC_SYS_TASKS
+	static IdleTask idleTask;
+	AddTask(& idleTask, Task::PriorityIdle, Task::ModePrivileged);
+#else
 	AddTask(new IdleTask(), Task::PriorityIdle, Task::ModePrivileged);
+#endif
+
+#if MACS_SOFT_TIMERS && MACS_SOFT_TIMER_TASK
+	SoftTimerRoom::GetInstance().StartTask();
+#endif
 	
 	m_initialized = true;
 	return ResultOk;
@@ -151,7 +199,7 @@ Result Scheduler::Start(bool use_preemption)
 	m_started = true;
 
 #if MACS_USE_CLOCK
-	m_cur_task->m_switch_cpu_tick = System::AskCurCpuTick();
+	m_load_start = m_cur_task->m_switch_cpu_tick = System::AskCurCpuTick();
 #endif
 	  
 	System::FirstSwitchToTask(m_cur_task->m_stack.m_top, m_cur_task->m_mode == Task::ModePrivileged);
@@ -272,7 +320,8 @@ Result Scheduler::AddTask(TaskIrq * task, int irq_num, Task::Priority priority,
 	if ( System::IsInInterrupt() && ! System::IsInSysCall() )
 		return ResultErrorInterruptNotSupported;
 
-	if ( ! task || ! IsPriorityValid(priority) )
+	// номер прерывания проверяется до изменения задачи: отвергнутый обработчик можно добавить повторно
+	if ( ! task || ! IsPriorityValid(priority) || ! TaskIrqRoom::IsValidIrq(irq_num) )
 		return ResultErrorInvalidArgs;
 
 	if ( task->m_state != Task::StateInactive )
@@ -297,6 +346,7 @@ extern "C" void MacsIrqHandler()
 {
 	CriticalSection _cs_;	
 	int inum = System::CurIrqNum();
+	MACS_TRACE(Irq, static_cast<uint16_t>(inum), 0);
 	Sch().ProceedIrq(inum);
 }
 	 
@@ -304,9 +354,7 @@ Result AddTaskIrq_Priv(Scheduler * scheduler, TaskIrq * task)
 {
 	CriticalSection _cs_;
 	
-	scheduler->m_irq_tasks.Add(task);
-
-	return ResultOk;
+	return scheduler->m_irq_tasks.Add(task) ? ResultOk : ResultErrorInvalidArgs;
 }
 
 Result DeleteTask_Priv(Scheduler * scheduler, Task * task, bool del_mem)
@@ -326,7 +374,8 @@ Result DeleteTask_Priv(Scheduler * scheduler, Task * task, bool del_mem)
 		
 	task->DetachFromSync();
 		
-	scheduler->m_irq_tasks.Del((TaskIrq *) task);
+	if ( task->m_irq_handler )	// у остальных задач полей TaskIrq нет
+		scheduler->m_irq_tasks.Del(static_cast<TaskIrq *>(task));
 
 #if MACS_MPU_PROTECT_STACK		
 	if ( is_suicide )  
@@ -406,6 +455,7 @@ Result BlockCurrentTask_Priv(Scheduler * scheduler, uint32_t timeout_ms, Task::U
 
 	scheduler->m_cur_task->m_dream_ticks = (timeout_ms != INFINITE_TIMEOUT ? MsToTicks(timeout_ms) : ULONG_MAX);
 	scheduler->m_sleep_tasks.Insert(scheduler->m_cur_task);
+	MACS_TRACE(Block, Trace::Id(scheduler->m_cur_task), 0);
 
 	scheduler->TryContextSwitch();
 
@@ -455,6 +505,10 @@ bool Scheduler::UnblockTaskInternal(Task * task, Task::UnblockReason reason)
 
 	task->m_unblock_reason = reason;
 	task->m_state = Task::StateReady;
+	MACS_TRACE(Unblock, Trace::Id(task), static_cast<uint8_t>(reason));
+#if MACS_TASK_NOTIFY
+	task->m_notify_waiting = false;
+#endif
 	if ( task != m_cur_task )
 		m_work_tasks.Insert(task);
 
@@ -469,7 +523,13 @@ bool Scheduler::UnblockTaskInternal(Task * task, Task::UnblockReason reason)
 
 void _SetTaskPriority_Priv(Scheduler * scheduler, Task * task, Task::Priority priority)
 {
-	task->m_priority = priority;
+	if ( task->m_state == Task::StateReady ) {
+		scheduler->m_work_tasks.Remove(task);
+		task->m_priority = priority;
+		scheduler->m_work_tasks.Insert(task);
+	} else {
+		task->m_priority = priority;
+	}
 	if ( scheduler->m_use_preemption )
 		scheduler->Yield();
 }
@@ -491,11 +551,12 @@ Result IntSetTaskPriority_Priv(Scheduler * scheduler, Task * task, Task::Priorit
 	if ( task->m_priority == priority )
 		return ResultOk;
 
-	task->m_priority = priority;
-
 	if ( task->m_state == Task::StateReady ) {
-		scheduler->m_work_tasks.Remove(task);	// Эта последовательность поместит задачу на нужное место
+		scheduler->m_work_tasks.Remove(task);	// Задача переносится в очередь нового приоритета
+		task->m_priority = priority;
 		scheduler->m_work_tasks.Insert(task);
+	} else {
+		task->m_priority = priority;
 	}
 
 #if MACS_MUTEX_PRIORITY_INVERSION
@@ -546,6 +607,7 @@ void Scheduler::TuneProfiler()
 bool Scheduler::SysTickHandler()
 {
 	CriticalSection _cs_;
+	PROF_EYE(PE_SYS_TICK, sys_tick);
 	++ m_tick_count;
 
 #if MACS_USE_CLOCK
@@ -556,6 +618,10 @@ bool Scheduler::SysTickHandler()
 	if ( ! m_started )
 		return false;
 
+#if MACS_USE_CLOCK
+	TickLoadWindow(1);
+#endif
+
 	m_sleep_tasks.Tick();
 	for(;;) {
 		Task * awake_task = m_sleep_tasks.Fetch();
@@ -566,6 +632,10 @@ bool Scheduler::SysTickHandler()
 		}
 	}
 
+#if MACS_SOFT_TIMERS
+	SoftTimerRoom::GetInstance().Tick(m_tick_count);
+#endif
+
 #if ! MACS_IRQ_FAST_SWITCH		
 	if ( m_irq_tasks.NeedIrqActivate() )
 		m_irq_tasks.ActivateTasks();
@@ -582,6 +652,44 @@ bool Scheduler::SysTickHandler()
 	return IsContextSwitchRequired();
 }
 
+#if MACS_TICKLESS_IDLE
+// Вызывается только задачей холостого хода (в привилегированном режиме).
+void Scheduler::TicklessIdle()
+{
+	System::DisableAllIrq();
+	
+	if ( ! m_work_tasks.Qty() && ! m_pending_swc && ! m_pause_cnt && ! m_irq_tasks.NeedIrqActivate() ) {
+		uint32_t idle_ticks = m_sleep_tasks.TicksToWakeup();
+#if MACS_SOFT_TIMERS
+		const uint32_t timer_ticks = SoftTimerRoom::GetInstance().TicksToExpire(m_tick_count);
+		if ( timer_ticks < idle_ticks )
+			idle_ticks = timer_ticks;
+#endif
+		if ( idle_ticks >= MACS_TICKLESS_MIN_TICKS ) 
+			SkipTicks(System::SleepTicks(idle_ticks));
+		else
+			System::EnterSleepMode();
+	}
+	
+	System::EnableAllIrq();
+}
+
+// Учитывает тики, пропущенные во время сна, за один шаг. 
+// Их количество меньше остатка сна первой задачи, поэтому пробуждений здесь не бывает.
+void Scheduler::SkipTicks(uint32_t ticks)
+{
+	if ( ! ticks )
+		return;
+
+	m_tick_count += ticks;
+#if MACS_USE_CLOCK
+	Clock::OnTick(m_tick_count);
+	TickLoadWindow(ticks);
+#endif	
+	m_sleep_tasks.Skip(ticks);
+}
+#endif
+
 bool Scheduler::IsContextSwitchRequired()
 {
 	// если есть всего одна высокоприоритетная задача, выполняющаяся в данный момент,
@@ -626,12 +734,19 @@ StackPtr Scheduler::SwitchContext(StackPtr new_sp)
 		
 	if ( m_cur_task ) {
 #if MACS_USE_CLOCK
-		uint32_t duration = System::GetCurCpuTick() -	m_cur_task->m_switch_cpu_tick;
-		m_cur_task->m_run_duration.m_frac += duration;
-		m_cur_task->m_run_duration.Norm();
+		// только накопление, пересчет в секунды и проценты выполняется при запросе GetTasksInfo
+		SettleLoad(m_cur_task, System::GetCurCpuTick());
 #endif	
 		m_cur_task->m_stack.m_top = new_sp;
 
+#if (__FPU_USED == 1)
+		if ( ! m_cur_task->m_fpu_used && StackFramePtr::isExtendedFrame(new_sp.m_sp) ) {
+			m_cur_task->m_fpu_used = true;
+			if ( m_cur_task->m_no_fpu && m_cur_task->GetStackLen() < TaskStack::MIN_SIZE )
+				MACS_ALARM(AR_FPU_UNDECLARED);
+		}
+#endif
+
 #if MACS_DEBUG		
 		bool res = m_cur_task->m_stack.Check();
 		if ( ! res ) 
@@ -645,6 +760,7 @@ StackPtr Scheduler::SwitchContext(StackPtr new_sp)
 #endif
 		  
 	SelectNextTask();
+	MACS_TRACE(Switch, Trace::Id(m_cur_task), static_cast<uint8_t>(m_cur_task->m_priority));
 	
 #if MACS_MPU_PROTECT_STACK		
 	m_cur_task->m_stack.SetMpuMine();	
@@ -665,14 +781,50 @@ extern "C" bool SchedulerSysTickHandler()
 }
 
 ////////////////////////////////////////////////////////////////
+TaskIrqRoom::TaskIrqRoom()
+{
+	m_event = false;
+	for ( int i = 0; i < SLOT_QTY; ++ i )
+		m_irq_tasks[i] = nullptr;
+	for ( int i = 0; i < MAP_WORDS; ++ i )
+		m_pending[i] = 0;
+}
+
+bool TaskIrqRoom::Add(TaskIrq * task)
+{
+	int slot = Slot(task->m_irq_num);
+	if ( slot < 0 )
+		return false;
+	TaskIrqList::Add(m_irq_tasks[slot], task);
+	task->m_irq_handler = true;
+	return true;
+}
+
+// Вызывается только для зарегистрированных обработчиков (Task::m_irq_handler), поэтому
+// просматривается лишь цепочка обслуживаемого прерывания
+void TaskIrqRoom::Del(TaskIrq * task)
+{
+	TaskIrq ** ptr = TaskIrqList::Find(m_irq_tasks[Slot(task->m_irq_num)], task);
+	if ( * ptr ) {
+		* ptr = TaskIrqList::Next(task);
+		TaskIrqList::Next(task) = nullptr;
+	}
+	task->m_irq_handler = false;
+	task->m_irq_num = -1;	// удаленный обработчик может быть добавлен снова
+}
+
 void TaskIrqRoom::ProceedIrq(int irq_num)
 {
-	for ( TaskIrq * ptsk = m_irq_task_list; ptsk != nullptr; ptsk = TaskIrqList::Next(ptsk) ) 
-		if ( ptsk->m_irq_num == irq_num ) {
-			if ( ptsk->GetState() == Task::StateBlocked && ! ptsk->m_unblock_func ) 
-				m_event = true;
-			ptsk->m_irq_up = true;
-		}
+	int slot = Slot(irq_num);
+	if ( slot < 0 || ! m_irq_tasks[slot] )
+		return;
+	
+	for ( TaskIrq * ptsk = m_irq_tasks[slot]; ptsk != nullptr; ptsk = TaskIrqList::Next(ptsk) ) {
+		if ( ptsk->GetState() == Task::StateBlocked && ! ptsk->m_unblock_func ) 
+			m_event = true;
+		ptsk->m_irq_up = true;
+	}
+	m_pending[slot / MAP_BITS] |= 1u << (slot % MAP_BITS);
 #if MACS_IRQ_FAST_SWITCH
 	if ( m_event && Sch().m_started ) {
 		Sch().m_pending_swc = true;
@@ -681,17 +833,137 @@ void TaskIrqRoom::ProceedIrq(int irq_num)
 #endif
 }
   
-void TaskIrqRoom::ActivateTasks()
+// Возвращает истину, если остались обработчики, которые еще не готовы принять прерывание
+bool TaskIrqRoom::ActivateSlot(int slot)
 {
-	for ( TaskIrq * ptsk = m_irq_task_list; ptsk != nullptr; ptsk = TaskIrqList::Next(ptsk) ) 
-		if ( ptsk->m_irq_up && ptsk->GetState() == Task::StateBlocked && ! ptsk->m_unblock_func ) {
+	bool rest = false;
+	for ( TaskIrq * ptsk = m_irq_tasks[slot]; ptsk != nullptr; ptsk = TaskIrqList::Next(ptsk) ) {
+		if ( ! ptsk->m_irq_up )
+			continue;
+		if ( ptsk->GetState() == Task::StateBlocked && ! ptsk->m_unblock_func ) {
 			Sch().m_sleep_tasks.Remove(ptsk);
 			Sch().UnblockTaskInternal(ptsk, Task::UnblockReasonIrq);
 			ptsk->m_irq_up = false;
+		} else {
+			rest = true;
 		}
+	}
+	return rest;
+}
+
+void TaskIrqRoom::ActivateTasks()
+{
+	for ( int word = 0; word < MAP_WORDS; ++ word ) {
+		uint32_t bits = m_pending[word];
+		m_pending[word] = 0;
+		while ( bits ) {
+			uint bit = (MAP_BITS - 1) - MACS_CLZ(bits);
+			bits &= ~(1u << bit);
+			if ( ActivateSlot(word * MAP_BITS + bit) )
+				m_pending[word] |= 1u << bit;
+		}
+	}
 	m_event = false;
 }
 ////////////////////////////////////////////////////////////////
+#if MACS_IRQ_POST
+
+#if MACS_IRQ_POST_QTY & (MACS_IRQ_POST_QTY - 1)
+	#error MACS_IRQ_POST_QTY must be a power of 2
+#endif
+
+IrqPostRoom::IrqPostRoom() :
+	m_head(0),
+	m_tail(0)
+{
+	for ( uint32_t i = 0; i < MACS_IRQ_POST_QTY; ++ i )
+		m_posts[i].m_ready = false;
+}
+
+// Резервирует элемент очереди. На ядрах M3 и выше - без критической секции, 
+// поэтому вызов может быть прерван производителем с большим приоритетом
+bool IrqPostRoom::Reserve(uint32_t & pos)
+{
+#if MACS_MCU_CORE >= MACS_CORTEX_M3
+	do {
+		pos = MACS_LDREXW((uint32_t *) & m_head);
+		if ( pos - m_tail >= MACS_IRQ_POST_QTY ) {
+			__CLREX();	// выход без STREX: монитор сбрасывается, чтобы не повлиять на чужую пару LDREX/STREX
+			return false;
+		}
+	} while ( MACS_STREXW(pos + 1, (uint32_t *) & m_head) );
+	return true;
+#else
+	const uint32_t mask = System::DisableIrq();
+	pos = m_head;
+	const bool res = pos - m_tail < MACS_IRQ_POST_QTY;
+	if ( res )
+		m_head = pos + 1;
+	System::EnableIrq(mask);
+	return res;
+#endif
+}
+
+bool IrqPostRoom::Put(void * obj, void * arg1, void * arg2, EPrivilegedMethods method)
+{
+	uint32_t pos;
+	if ( ! Reserve(pos) )
+		return false;
+
+	Post & post = m_posts[pos & (MACS_IRQ_POST_QTY - 1)];
+	post.m_obj = obj;
+	post.m_arg1 = arg1;
+	post.m_arg2 = arg2;
+	post.m_method = method;
+	__DMB();
+	post.m_ready = true;
+	return true;
+}
+
+bool IrqPostRoom::Drain()
+{
+	bool res = false;
+	// PendSV имеет наименьший приоритет, поэтому прервавший его производитель успевает завершить запись.
+	// Незавершенный элемент (и все последующие) останется до следующего PendSV.
+	while ( m_tail != m_head ) {
+		Post & post = m_posts[m_tail & (MACS_IRQ_POST_QTY - 1)];
+		if ( ! post.m_ready )
+			break;
+
+		void * const obj = post.m_obj, * const arg1 = post.m_arg1, * const arg2 = post.m_arg2;
+		const uint32_t method = post.m_method;
+		post.m_ready = false;
+		__DMB();
+		++ m_tail;
+
+		Invoke(obj, arg1, arg2, method);
+		res = true;
+	}
+	return res;
+}
+
+Result IrqPostRoom::Invoke(void * obj, void * arg1, void * arg2, uint32_t method)
+{
+	_ASSERT(method < EPM_Count);
+
+	// вызов через таблицу svcMethods, как и в обработчике SVC
+	typedef Result (* PrivMethod)(void *, void *, void *);
+	return reinterpret_cast<PrivMethod>(svcMethods[method + 1])(obj, arg1, arg2);
+}
+
+Result Scheduler::PostFromIrq(void * obj, void * arg1, void * arg2, EPrivilegedMethods method)
+{
+	// при переполнении очереди операция выполняется, как и прежде, в самом прерывании
+	if ( ! m_irq_posts.Put(obj, arg1, arg2, method) )
+		return IrqPostRoom::Invoke(obj, arg1, arg2, method);
+
+	CriticalSection _cs_;
+	TryContextSwitch();
+	return ResultOk;
+}
+
+#endif
+////////////////////////////////////////////////////////////////
 uint32_t Read_Cpu_Tick_Priv() { return System::GetCurCpuTick(); }
  
 uint Scheduler::GetTasksQty()
@@ -699,20 +971,84 @@ uint Scheduler::GetTasksQty()
 	return m_work_tasks.Qty() + m_sleep_tasks.Qty() + (m_cur_task ? 1 : 0); 
 }
 
+uint Scheduler::GetTasks(Task ** tasks, uint max_qty)
+{
+	PauseSection _ps_;
+
+	uint qty = 0;
+	if ( m_cur_task && qty < max_qty )
+		tasks[qty ++] = m_cur_task;
+	for ( Task * task = m_work_tasks.FirstTask(); task != nullptr && qty < max_qty; task = m_work_tasks.NextTask(task) )
+		tasks[qty ++] = task;
+	for ( Task * task = m_sleep_tasks.FirstTask(); task != nullptr && qty < max_qty; task = task->m_next_sched_task )
+		tasks[qty ++] = task;
+
+	return qty;
+}
+
 #if MACS_USE_CLOCK
 void TaskInfo::PrintHeader(String & str)	
 {
-	str.Add("        Task  Pr   Cpu. tm.  Stck a/u");
+	str.Add("        Task  Pr F   Cpu. tm.    Load  Stck a/u");
 }
  
 void TaskInfo::Print(String & str)	
 {
 	String prior_str; PrintPriority(prior_str, m_priority);
-	str.Add(PrnFmt("%12.12s  %2.2s  %9.9s  %ld/%ld", m_name, prior_str.Z(), m_dur.ToStr(), m_stack_usage, m_stack_len));
+	str.Add(PrnFmt("%12.12s  %2.2s %c  %9.9s  %3u.%u%%  %ld/%ld", m_name, prior_str.Z(), m_fpu_used ? 'F' : ' ', m_dur.ToStr(), 
+	               m_load / 10, m_load % 10, m_stack_usage, m_stack_len));
+}
+
+// Завершает окно расчета загрузки, если оно истекло. Задачи здесь не перебираются: каждая задача
+// переносит свое время в завершенное окно сама, при переключении контекста (см. SettleLoad).
+void Scheduler::TickLoadWindow(uint32_t ticks)
+{
+	m_load_ticks += ticks;
+	if ( m_load_ticks < System::GetTickRate() * MACS_CPU_LOAD_WINDOW )
+		return;
+	m_load_ticks = 0;
+
+	const uint32_t now = System::GetCurCpuTick();
+	m_load_window = now - m_load_start;
+	m_load_start = now;
+	++ m_load_seq;
+}
+
+// Такты текущего кванта выполняющейся задачи, пришедшиеся на время до начала текущего окна
+uint32_t Scheduler::SliceBeforeWindow(const Task * task, uint32_t now) const
+{
+	const uint32_t slice = now - task->m_switch_cpu_tick;
+	const uint32_t in_window = now - m_load_start;
+	return slice > in_window ? slice - in_window : 0;
+}
+
+// Процессорное время задачи за последнее завершенное окно. Задача, не переключавшаяся с начала 
+// текущего окна, еще хранит время своего окна: если это предыдущее окно, оно и есть искомое,
+// если более раннее - в последнем окне задача выполнялась только текущим квантом (before).
+uint32_t Scheduler::LoadCycles(const Task * task, uint32_t before) const
+{
+	if ( task->m_load_seq == m_load_seq )
+		return task->m_load_cycles;
+	if ( task->m_load_seq + 1 == m_load_seq )
+		return MIN(static_cast<uint32_t>(task->m_run_cycles - task->m_load_base) + before, m_load_window);
+	return MIN(before, m_load_window);
+}
+
+// Учитывает квант задачи, завершающийся в момент now, и переносит время задачи в окно m_load_seq
+void Scheduler::SettleLoad(Task * task, uint32_t now)
+{
+	const uint32_t before = SliceBeforeWindow(task, now);
+	if ( task->m_load_seq != m_load_seq ) {
+		task->m_load_cycles = LoadCycles(task, before);
+		task->m_load_base = task->m_run_cycles + before;
+		task->m_load_seq = m_load_seq;
+	}
+	task->m_run_cycles += now - task->m_switch_cpu_tick;
 }
   
-void Scheduler::CollectTasksInfo(DynArr<TaskInfo> & info, Task * task, bool is_list)
+void Scheduler::CollectTasksInfo(DynArr<TaskInfo> & info, Task * task, bool is_list, uint32_t now)
 {
+	const uint32_t freq = System::GetCpuFreq();
 	while ( task ) {
 		TaskInfo tinfo;
 		CSPTR tname = task->GetName();
@@ -721,7 +1057,19 @@ void Scheduler::CollectTasksInfo(DynArr<TaskInfo> & info, Task * task, bool is_l
 			tinfo.m_name[sizeof(tinfo.m_name) - 1] = '\0';
 		} 
 		tinfo.m_priority = task->m_priority;
-		tinfo.m_dur = task->m_run_duration;
+		tinfo.m_fpu_used = task->m_fpu_used;
+
+		// состояние задачи не изменяется (метод доступен и непривилегированным задачам),
+		// время распределяется по окнам так же, как это сделает SettleLoad при переключении
+		uint64_t cycles = task->m_run_cycles;
+		uint32_t before = 0;
+		if ( task == m_cur_task ) {
+			cycles += now - task->m_switch_cpu_tick;
+			before = SliceBeforeWindow(task, now);
+		}
+		tinfo.m_dur.m_scnd = static_cast<uint32_t>(cycles / freq);
+		tinfo.m_dur.m_frac = static_cast<uint32_t>(cycles % freq);
+		tinfo.m_load = m_load_window ? static_cast<uint>(static_cast<uint64_t>(LoadCycles(task, before)) * 1000 / m_load_window) : 0;
 		
 		tinfo.m_stack_len = task->GetStackLen();
 		tinfo.m_stack_usage = task->GetStackUsage();
@@ -741,36 +1089,112 @@ Result Scheduler::GetTasksInfo(DynArr<TaskInfo> & info)
 	info.Clear();
 	info.SetCapacity(tqty);
 	
-	CollectTasksInfo(info, m_cur_task, false);
-	CollectTasksInfo(info, m_work_tasks.FirstTask(), true);
-	CollectTasksInfo(info, m_sleep_tasks.FirstTask(), true);
+	const uint32_t now = System::AskCurCpuTick();
+	CollectTasksInfo(info, m_cur_task, false, now);
+	for ( Task * task = m_work_tasks.FirstTask(); task != nullptr; task = m_work_tasks.NextTask(task) )
+		CollectTasksInfo(info, task, false, now);
+	CollectTasksInfo(info, m_sleep_tasks.FirstTask(), true, now);
 
 	return ResultOk;
 }
 #endif
 ////////////////////////////////////////////////////////////////
-void TaskWorkRoom::Insert(Task * task)
+TaskWorkRoom::TaskWorkRoom()
 {
-	_ASSERT(! Sch().m_sleep_tasks.IsInList(task));
+	for ( uint i = 0; i < PRIOR_QTY; ++ i )
+		m_head[i] = m_tail[i] = nullptr;
+	for ( uint i = 0; i < MAP_WORDS; ++ i )
+		m_ready_map[i] = 0;
+	m_group_map = 0;
+	m_qty = 0;
+}
+
+// Задача должна находиться на уровне своего текущего приоритета, поэтому смена 
+// приоритета готовой задачи выполняется только после ее удаления из очереди.
+void TaskWorkRoom::Remove(Task * task)
+{
+	const uint prior = task->m_priority;
+	Task * prev = nullptr;
+	for ( Task * ptsk = m_head[prior]; ptsk != nullptr; prev = ptsk, ptsk = ptsk->m_next_sched_task ) {
+		if ( ptsk != task )
+			continue;
+		if ( prev )
+			prev->m_next_sched_task = task->m_next_sched_task;
+		else
+			m_head[prior] = task->m_next_sched_task;
+		if ( m_tail[prior] == task )
+			m_tail[prior] = prev;
+		if ( ! m_head[prior] )
+			UnmarkLevel(prior);
+		task->m_next_sched_task = nullptr;
+		-- m_qty;
+		return;
+	}
+}
 
-	TaskWorkList::Add(m_task_list, task);		
+Task * TaskWorkRoom::NextTask(const Task * task) const
+{
+	if ( task->m_next_sched_task )
+		return task->m_next_sched_task;
+	for ( uint prior = task->m_priority; prior-- > 0; )
+		if ( m_head[prior] )
+			return m_head[prior];
+	return nullptr;
+}
+
+#if MACS_DEBUG	
+bool TaskWorkRoom::IsInList(Task * task) const
+{
+	return !! * TaskRoomList::Find(const_cast<Task *&>(m_head[task->m_priority]), task);
 }
+#endif	
 
 void TaskSleepRoom::Insert(Task * task)
 {
 	_ASSERT(task->m_dream_ticks);
+	_ASSERT(! task->m_sleep_link);
 	_ASSERT(! Sch().m_work_tasks.IsInList(task));
 	
-	TaskSleepList::Add(m_task_list, task);		
+	// Задачи с одинаковым временем пробуждения выстраиваются в порядке поступления
+	Task ** ptr = m_tail_link;
+	if ( task->m_dream_ticks != ULONG_MAX ) {
+		ptr = & m_task_list;
+		while ( * ptr && (* ptr)->m_dream_ticks != ULONG_MAX && (* ptr)->m_dream_ticks <= task->m_dream_ticks ) {
+			task->m_dream_ticks -= (* ptr)->m_dream_ticks;
+			ptr = & (* ptr)->m_next_sched_task;
+		}
+		if ( * ptr && (* ptr)->m_dream_ticks != ULONG_MAX )
+			(* ptr)->m_dream_ticks -= task->m_dream_ticks;
+	}
+	
+	task->m_next_sched_task = * ptr;
+	task->m_sleep_link = ptr;
+	if ( * ptr )
+		(* ptr)->m_sleep_link = & task->m_next_sched_task;
+	else
+		m_tail_link = & task->m_next_sched_task;
+	* ptr = task;
 }
- 
-void TaskSleepRoom::Tick()
+
+void TaskSleepRoom::Remove(Task * task)
 {
-	for ( Task * ptsk = m_task_list; ptsk != nullptr; ptsk = TaskSleepList::Next(ptsk) ) {
-		_ASSERT(ptsk->m_dream_ticks);
-		if ( ptsk->m_dream_ticks != ULONG_MAX )
-			-- ptsk->m_dream_ticks;
+	Task ** ptr = task->m_sleep_link;
+	if ( ! ptr )
+		return;
+	_ASSERT(* ptr == task);
+	
+	// Остаток сна удаляемой задачи переходит к следующей за ней
+	Task * next = task->m_next_sched_task;
+	if ( next ) {
+		if ( next->m_dream_ticks != ULONG_MAX )
+			next->m_dream_ticks += task->m_dream_ticks;
+		next->m_sleep_link = ptr;
+	} else {
+		m_tail_link = ptr;
 	}
+	* ptr = next;
+	task->m_next_sched_task = nullptr;
+	task->m_sleep_link = nullptr;
 }
 
 }	// namespace macs
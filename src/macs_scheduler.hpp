@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <limits.h>
 
 #include "macs_common.hpp"
 #include "macs_task.hpp"
@@ -36,36 +37,134 @@ public:
 	inline void Remove(Task * task) { TaskRoomList::Del(m_task_list, task); }
 };
 
+/// @brief Очередь заблокированных задач.
+/// @details Задачи с конечным таймаутом упорядочены по времени пробуждения, причем в m_dream_ticks 
+/// хранится не полное время сна, а приращение относительно предыдущей задачи (дельта-список).
+/// Поэтому на каждом тике уменьшается только счетчик первой задачи, а просыпающиеся задачи
+/// извлекаются из головы списка. Задачи с бесконечным таймаутом (ULONG_MAX) находятся в конце списка
+/// и добавляются туда без просмотра списка. Каждая задача хранит ссылку на указывающее на нее звено 
+/// (m_sleep_link), поэтому удаление задачи, разблокированной раньше срока, также не требует поиска.
 class TaskSleepRoom : public TaskRoom 
 {
+private:
+	Task ** m_tail_link;	// последнее (пустое) звено списка
 public:
-	inline void Insert(Task * task);
+	TaskSleepRoom() { m_tail_link = & m_task_list; }
+
+	void Insert(Task * task);
+	void Remove(Task * task);
 	inline Task * Fetch() 
 	{
-		return (m_task_list && ! m_task_list->m_dream_ticks) ? TaskSleepList::Fetch(m_task_list) : nullptr;
+		Task * task = m_task_list;
+		if ( ! task || task->m_dream_ticks )
+			return nullptr;
+		Remove(task);
+		return task;
 	}
 	
-	void Tick();
+	inline void Tick()
+	{
+		if ( m_task_list && m_task_list->m_dream_ticks != ULONG_MAX ) {
+			_ASSERT(m_task_list->m_dream_ticks);
+			-- m_task_list->m_dream_ticks;
+		}
+	}
+#if MACS_TICKLESS_IDLE
+	// Количество тиков до ближайшего пробуждения (ULONG_MAX - пробуждений по времени не ожидается)
+	inline uint32_t TicksToWakeup() const { return m_task_list ? m_task_list->m_dream_ticks : ULONG_MAX; }
+	inline void Skip(uint32_t ticks)
+	{
+		if ( m_task_list && m_task_list->m_dream_ticks != ULONG_MAX ) {
+			_ASSERT(m_task_list->m_dream_ticks > ticks);
+			m_task_list->m_dream_ticks -= ticks;
+		}
+	}
+#endif
 };
 
-class TaskWorkRoom : public TaskRoom 
+/// @brief Очередь готовых к выполнению задач.
+/// @details Для каждого уровня приоритета ведется собственная очередь FIFO (через поле m_next_sched_task),
+/// непустые уровни отмечаются в двухуровневой битовой карте. Поиск наиболее приоритетной задачи
+/// выполняется за O(1) с помощью подсчета старших нулевых битов (MACS_CLZ), постановка в очередь -
+/// добавлением в хвост уровня, что сохраняет поочередное выполнение задач одного приоритета (round robin).
+class TaskWorkRoom
 {
+private:
+	static const uint PRIOR_QTY = Task::PriorityInvalid;	// количество уровней приоритета (PriorityMax + 1)
+	static const uint MAP_BITS  = 32;
+	static const uint MAP_WORDS = (PRIOR_QTY + MAP_BITS - 1) / MAP_BITS;
+	typedef char PriorQtyCheck[MAP_WORDS <= MAP_BITS ? 1 : -1];	// количество уровней ограничено размером карты групп
+
+	Task * m_head[PRIOR_QTY];           // первые задачи уровней приоритета
+	Task * m_tail[PRIOR_QTY];           // последние задачи уровней приоритета
+	uint32_t m_ready_map[MAP_WORDS];    // бит установлен - на уровне есть готовые задачи
+	uint32_t m_group_map;               // бит установлен - в соответствующем слове m_ready_map есть установленные биты
+	ulong m_qty;
+
+	inline void MarkLevel(uint prior) {
+		m_ready_map[prior / MAP_BITS] |= 1u << (prior % MAP_BITS);
+		m_group_map |= 1u << (prior / MAP_BITS);
+	}
+	inline void UnmarkLevel(uint prior) {
+		if ( ! (m_ready_map[prior / MAP_BITS] &= ~(1u << (prior % MAP_BITS))) )
+			m_group_map &= ~(1u << (prior / MAP_BITS));
+	}
+	// Возвращает наивысший непустой уровень приоритета, пустая очередь не допускается
+	inline uint TopLevel() const {
+		uint word = (MAP_BITS - 1) - MACS_CLZ(m_group_map);
+		return word * MAP_BITS + (MAP_BITS - 1) - MACS_CLZ(m_ready_map[word]);
+	}
 public:
+	TaskWorkRoom();
+
+	      Task * FirstTask()       { return m_group_map ? m_head[TopLevel()] : nullptr; }
+	const Task * FirstTask() const { return m_group_map ? m_head[TopLevel()] : nullptr; }
+	// Следующая задача в порядке выполнения (для обхода очереди)
+	Task * NextTask(const Task * task) const;
+	ulong Qty() const { return m_qty; }
+#if MACS_DEBUG	
+	bool IsInList(Task * task) const;
+#endif	
+
 	inline void Insert(Task * task);
-	inline Task * Fetch() { return TaskWorkList::Fetch(m_task_list); }
+	inline Task * Fetch();
+	void Remove(Task * task);
 };
 
 SLIST_DECLARE(TaskIrqList, TaskIrq, m_next_irq_task); 
+/// @brief Задачи-обработчики прерываний.
+/// @details Обработчики хранятся в таблице, индексируемой номером прерывания (системные исключения,
+/// внешние прерывания и виртуальные прерывания), поэтому поиск обработчиков не зависит от их общего количества.
+/// Сработавшие прерывания отмечаются в битовой карте, по которой ActivateTasks обходит только их обработчики.
 class TaskIrqRoom 
 {
 private:
-	TaskIrq * m_irq_task_list;
+	static const int SYS_IRQ_QTY = SystemBase::FIRST_USER_INTERRUPT_NUMBER;	// номера системных исключений отрицательны
+	static const int SLOT_QTY = SYS_IRQ_QTY + MACS_IRQ_QTY + MACS_VIRT_IRQ_QTY;
+	static const int MAP_BITS = 32;
+	static const int MAP_WORDS = (SLOT_QTY + MAP_BITS - 1) / MAP_BITS;
+
+	TaskIrq * m_irq_tasks[SLOT_QTY];	// цепочки обработчиков для каждого прерывания
+	uint32_t m_pending[MAP_WORDS];    // прерывания, обработчики которых ждут активации
 	bool m_event;	// Необходима обработка события
+
+	// Возвращает индекс в таблице обработчиков или -1 для недопустимого номера прерывания
+	static inline int Slot(int irq_num) {
+		if ( irq_num >= -SYS_IRQ_QTY && irq_num < MACS_IRQ_QTY )
+			return irq_num + SYS_IRQ_QTY;
+		if ( irq_num >= FIRST_VIRT_IRQ && irq_num < FIRST_VIRT_IRQ + MACS_VIRT_IRQ_QTY )
+			return irq_num - FIRST_VIRT_IRQ + SYS_IRQ_QTY + MACS_IRQ_QTY;
+		return -1;
+	}
+	bool ActivateSlot(int slot);
 public:
-	TaskIrqRoom() { m_event = false; m_irq_task_list = nullptr; }
+	TaskIrqRoom();
+
+	// Есть ли в таблице место для обработчиков прерывания irq_num
+	static inline bool IsValidIrq(int irq_num) { return Slot(irq_num) >= 0; }
 	
-	inline void Add(TaskIrq * task) { TaskIrqList::Add(m_irq_task_list, task); }
-	inline void Del(TaskIrq * task) { TaskIrqList::Del(m_irq_task_list, task); }
+	bool Add(TaskIrq * task);
+	void Del(TaskIrq * task);
 	
 	void ProceedIrq(int irq_num);
 
@@ -73,6 +172,45 @@ public:
 	bool NeedIrqActivate() { return m_event; }
 }; 
  
+#if MACS_IRQ_POST
+/// @brief Очередь операций ядра, отложенных из прерываний.
+/// @details Прерывание только записывает вызов (индекс привилегированного метода и его аргументы) 
+/// в очередь без критической секции, а сами методы с работой над списками задач выполняются пачкой 
+/// из PendSV перед переключением контекста. Очередь допускает несколько производителей (прерывания 
+/// любого приоритета) и одного потребителя (PendSV).
+class IrqPostRoom
+{
+private:
+	struct Post
+	{
+		void * m_obj;
+		void * m_arg1;
+		void * m_arg2;
+		uint32_t m_method;        // EPrivilegedMethods
+		volatile bool m_ready;    // запись элемента завершена
+	};
+
+	Post m_posts[MACS_IRQ_POST_QTY];
+	volatile uint32_t m_head;   // следующий резервируемый элемент (производители)
+	volatile uint32_t m_tail;   // следующий выполняемый элемент (потребитель)
+
+	bool Reserve(uint32_t & pos);
+public:
+	IrqPostRoom();
+
+	// Записывает вызов в очередь, возвращает false при переполнении очереди
+	bool Put(void * obj, void * arg1, void * arg2, EPrivilegedMethods method);
+
+	// Выполняет все записанные вызовы, возвращает false, если очередь была пуста
+	bool Drain();
+
+	bool IsEmpty() const { return m_tail == m_head; }
+
+	// Выполняет привилегированный метод с индексом method
+	static Result Invoke(void * obj, void * arg1, void * arg2, uint32_t method);
+};
+#endif
+
 #if MACS_USE_CLOCK
 class TaskInfo
 {
@@ -80,9 +218,11 @@ public:
 	char m_name[12];
 	Task::Priority m_priority;
 	Time m_dur;
+	uint m_load;	// загрузка процессора задачей за последнее окно MACS_CPU_LOAD_WINDOW (в десятых долях процента)
+	bool m_fpu_used;
 	size_t m_stack_len, m_stack_usage;
 public:
-	TaskInfo() { m_name[0] = '\0'; m_priority = Task::PriorityInvalid; m_dur.Zero(); m_stack_len = m_stack_usage = 0; }
+	TaskInfo() { m_name[0] = '\0'; m_priority = Task::PriorityInvalid; m_dur.Zero(); m_load = 0; m_fpu_used = false; m_stack_len = m_stack_usage = 0; }
 	static void PrintHeader(String &);
 	void Print(String &);	
 };
@@ -172,6 +312,14 @@ public:
 	/// @return Количество задач в планировщике
 	uint GetTasksQty();
 
+	/// @brief Получить список задач
+	/// @details Заполняет массив указателями на задачи планировщика (выполняющуюся, готовые к выполнению
+	/// и заблокированные) на момент вызова функции.
+	/// @param tasks - массив для указателей на задачи
+	/// @param max_qty - размер массива
+	/// @return Количество записанных указателей
+	uint GetTasks(Task ** tasks, uint max_qty);
+
 #if MACS_USE_CLOCK
 	Result GetTasksInfo(DynArr<TaskInfo> &);
 #endif	
@@ -187,6 +335,10 @@ private:
 	void SelectNextTask();
 public:
 	StackPtr SwitchContext(StackPtr new_sp);
+#if MACS_IRQ_POST
+	// Откладывает вызов привилегированного метода из прерывания до PendSV. Только для вызова ядром!
+	Result PostFromIrq(void * obj, void * arg1, void * arg2, EPrivilegedMethods method);
+#endif
 	inline void TryContextSwitch() { // Только для вызова из критической секции!
 		if ( ! m_pause_flg && m_pause_cnt == 0 )
 			System::SwitchContext();
@@ -195,11 +347,19 @@ public:
 	}
 private:
 	bool SysTickHandler();
+#if MACS_TICKLESS_IDLE
+	void TicklessIdle();
+	void SkipTicks(uint32_t ticks);
+#endif
 	bool IsContextSwitchRequired();
 	bool IsPriorityValid(Task::Priority priority);
 	void TuneProfiler();
 #if MACS_USE_CLOCK
-	void CollectTasksInfo(DynArr<TaskInfo> &, Task *, bool is_list);
+	void CollectTasksInfo(DynArr<TaskInfo> &, Task *, bool is_list, uint32_t now);
+	void TickLoadWindow(uint32_t ticks);
+	uint32_t SliceBeforeWindow(const Task * task, uint32_t now) const;
+	uint32_t LoadCycles(const Task * task, uint32_t before) const;
+	void SettleLoad(Task * task, uint32_t now);
 #endif
 
 	// Добавляет задачу в планировщик и выполняет переключение контекста.
@@ -230,6 +390,7 @@ private:
 	friend class TaskWorkRoom;
 #endif		
 	friend class PauseSection;
+	friend class IdleTask;
 	friend void MacsIrqHandler();
 
 	static Scheduler m_instance;
@@ -237,6 +398,9 @@ private:
 	TaskSleepRoom m_sleep_tasks;
 	TaskWorkRoom	m_work_tasks;
 	TaskIrqRoom 	m_irq_tasks;
+#if MACS_IRQ_POST
+	IrqPostRoom   m_irq_posts;
+#endif
 
 	Task * m_cur_task;	// Текущая задача хранится только здесь - в списке ее нет!
 	volatile uint32_t m_tick_count;
@@ -247,10 +411,52 @@ private:
 	uint m_pause_cnt;
 	bool m_pending_swc;
 	bool m_use_preemption;
+
+#if MACS_USE_CLOCK
+	uint32_t m_load_ticks;    // тиков с начала текущего окна загрузки
+	uint32_t m_load_start;    // такт процессора в начале текущего окна загрузки
+	uint32_t m_load_window;   // длительность последнего завершенного окна загрузки в тактах
+	uint32_t m_load_seq;      // номер текущего окна загрузки
+#endif
 };	//  class Scheduler
 
 inline Scheduler & Sch() { return Scheduler::GetInstance(); }
 
+// Вставка и выборка выполняются при каждом переключении контекста, поэтому определены здесь
+// (после Sch(), которая нужна проверке в отладочной сборке)
+inline void TaskWorkRoom::Insert(Task * task)
+{
+	_ASSERT(! Sch().m_sleep_tasks.IsInList(task));
+
+	const uint prior = task->m_priority;
+	task->m_next_sched_task = nullptr;
+	if ( m_tail[prior] ) {
+		m_tail[prior]->m_next_sched_task = task;
+	} else {
+		m_head[prior] = task;
+		MarkLevel(prior);
+	}
+	m_tail[prior] = task;
+	++ m_qty;
+}
+
+inline Task * TaskWorkRoom::Fetch()
+{
+	if ( ! m_group_map )
+		return nullptr;
+
+	const uint prior = TopLevel();
+	Task * task = m_head[prior];
+	m_head[prior] = task->m_next_sched_task;
+	if ( ! m_head[prior] ) {
+		m_tail[prior] = nullptr;
+		UnmarkLevel(prior);
+	}
+	task->m_next_sched_task = nullptr;
+	-- m_qty;
+	return task;
+}
+
 class PauseSection
 {
 public:
@@ -124,6 +124,14 @@ public:
 	{
 		return 0xFFFFFFFD;
 	}
+
+	// Бит 4 EXC_RETURN сброшен, если аппаратный фрейм расширенный (содержит контекст FPU)
+	static const uint32_t EXC_RETURN_STD_FRAME = 0x10;
+
+	static bool isExtendedFrame(const void * ptr)
+	{
+		return ! (static_cast<const SoftwareStackFrame*>(ptr)->EXC_RETURN & EXC_RETURN_STD_FRAME);
+	}
 };
 
 }	// namespace macs
@@ -13,6 +13,7 @@
 #include "macs_critical_section.hpp"
 #include "macs_scheduler.hpp"
 #include "macs_stack_frame.hpp"
+#include "macs_trace.hpp"
    
 namespace macs {
 	
@@ -28,17 +29,32 @@ void Task::Init(const char * name, size_t stack_len, uint32_t * stack_mem)
 #else		
 	m_mode = ModeUnprivileged;
 #endif		
+	m_no_fpu = m_fpu_used = m_irq_handler = false;
+#if MACS_MEM_TASK_ARENA
+	m_arena = nullptr;
+	m_arena_on = false;
+#endif
 	
 #if MACS_USE_CLOCK
-	m_run_duration.Zero();
+	m_run_cycles = m_load_base = 0;
+	m_load_cycles = m_load_seq = 0;
 #endif
 	 
 	m_dream_ticks = 0;
 	m_next_sched_task = nullptr;
+	m_sleep_link = nullptr;
 	m_next_sync_task = nullptr;
 	m_unblock_func = nullptr;
 	m_owned_obj_list = nullptr;
 	m_unblock_reason = UnblockReasonNone;
+#if MACS_TASK_NOTIFY
+	m_notify_value = m_notify_recv = m_notify_clear = 0;
+	m_notify_pending = m_notify_waiting = false;
+#endif
+#if MACS_EVENT_GROUPS
+	m_flags_wait = m_flags_recv = 0;
+	m_flags_options = 0;
+#endif
 	
 	if ( name )	{
 #if MACS_TASK_NAME_LENGTH > 0	 
@@ -46,9 +62,11 @@ void Task::Init(const char * name, size_t stack_len, uint32_t * stack_mem)
 #elif MACS_TASK_NAME_LENGTH == -1	  	
 		m_name_ptr = new char[strlen(name) + 1];
 		strcpy(const_cast<char *>(m_name_ptr), name);
+#elif MACS_TASK_NAME_LENGTH == -2
+		m_name_ptr = name;
 #endif					
 	} else {
-#if MACS_TASK_NAME_LENGTH == -1	  	
+#if MACS_TASK_NAME_LENGTH < 0
 		m_name_ptr = nullptr;
 #endif					
 	}		
@@ -66,11 +84,15 @@ Task::~Task()
 	if ( m_name_ptr )
 		delete[] m_name_ptr;
 #endif					
+#if MACS_MEM_TASK_ARENA
+	delete m_arena;
+#endif
 }
 
 void Task::InitializeStack(size_t stack_size, void (* onTaskExit)(void))
 {
-	m_stack.Prepare(stack_size, this, reinterpret_cast<void (*)()>(GetExecuteAddress()), onTaskExit);
+	m_stack.Prepare(stack_size, this, reinterpret_cast<void (*)()>(GetExecuteAddress()), onTaskExit,
+	                m_no_fpu ? TaskStack::MIN_NOFPU_SIZE : TaskStack::MIN_SIZE);
 }
 
 Result Task::Add(Task * task, Task::Priority priority, Task::Mode mode, size_t stack_size)
@@ -78,6 +100,20 @@ Result Task::Add(Task * task, Task::Priority priority, Task::Mode mode, size_t s
 	return Sch().AddTask(task, priority, mode, stack_size); // Обработка профайлера в Scheduler
 }
 
+Result Task::AddTable(const TaskDesc * table, size_t qty)
+{
+	if ( ! table && qty )
+		return ResultErrorInvalidArgs;
+
+	loop ( size_t, index, qty ) {
+		const TaskDesc & desc = table[index];
+		Result res = Add(desc.task, desc.priority, desc.mode, desc.stack_size ? desc.stack_size : ENOUGH_STACK_SIZE);
+		if ( res != ResultOk )
+			return res;
+	}
+	return ResultOk;
+}
+
 Result Task::Remove()
 {
 	return Sch().DeleteTask(this, false);
@@ -106,6 +142,31 @@ Result Task::SetPriority(Priority value)
 	return Sch().SetTaskPriority(this, value);
 }
 
+#if MACS_MEM_TASK_ARENA
+Result Task::CreateArena(size_t size, void * mem)
+{
+	if ( m_arena )
+		return ResultErrorInvalidState;
+	if ( ! size )
+		return ResultErrorInvalidArgs;
+
+	// арена размещается в куче, даже если ее создает задача со своей включенной ареной
+	Task * cur = GetCurrent();
+	const bool cur_arena_on = cur && cur->UseArena(false);
+	Arena * arena = new Arena(size, mem);
+	if ( cur )
+		cur->UseArena(cur_arena_on);
+
+	if ( ! arena->IsReady() ) {
+		delete arena;
+		return ResultErrorInvalidArgs;
+	}
+	m_arena = arena;
+	m_arena_on = true;
+	return ResultOk;
+}
+#endif
+
 Task * Task::GetCurrent()
 {
 	return Sch().GetCurrentTask();
@@ -116,6 +177,94 @@ void Task::Yield()
 	Sch().Yield();
 }
 
+#if MACS_TASK_NOTIFY
+Result Task::Notify(uint32_t value, NotifyAction action)
+{
+	if ( ! Sch().IsStarted() ) 
+		return ResultErrorInvalidState;
+
+	if ( ! System::IsSysCallAllowed() ) 
+		return ResultErrorSysCallNotAllowed;
+
+#if MACS_IRQ_POST
+	if ( System::IsInInterrupt() && ! System::IsInSysCall() )
+		return Sch().PostFromIrq(this, reinterpret_cast<void*>(value), reinterpret_cast<void*>(action), EPM_Task_Notify_Priv);
+#endif
+
+	return System::IsInPrivOrIrq() ? Notify_Priv(this, value, action) 
+	                               : SvcExecPrivileged(this, reinterpret_cast<void*>(value), reinterpret_cast<void*>(action), EPM_Task_Notify_Priv);
+}
+
+Result Task::Notify_Priv(Task * task, uint32_t value, NotifyAction action)
+{
+	CriticalSection _cs_;
+	MACS_TRACE(TaskNotify, Trace::Id(task), static_cast<uint8_t>(action));
+
+	if ( task->m_state == StateInactive )
+		return ResultErrorInvalidState;
+
+	switch ( action ) {
+	case NotifySetBits :   task->m_notify_value |= value; break;
+	case NotifyIncrement : ++ task->m_notify_value;       break;
+	case NotifyOverwrite : task->m_notify_value = value;  break;
+	default :	
+		return ResultErrorInvalidArgs;
+	}
+	task->m_notify_pending = true;
+	
+	// ожидающая задача получает уведомление сразу, минуя списки объектов синхронизации
+	if ( task->m_notify_waiting && task->m_state == StateBlocked ) {
+		task->TakeNotify();
+		return UnblockTask_Priv(& Sch(), task);
+	}
+	return ResultOk;
+}
+
+Result Task::WaitNotify(uint32_t & value, uint32_t clear_mask, uint32_t timeout_ms)
+{
+	if ( ! Sch().IsStarted() ) 
+		return ResultErrorInvalidState;
+
+	if ( System::IsInInterrupt() ) 
+		return ResultErrorInterruptNotSupported;
+
+	Task * cur_task = GetCurrent();
+	Result res = System::IsInPrivOrIrq() ? WaitNotify_Priv(cur_task, clear_mask, timeout_ms) 
+	                                     : SvcExecPrivileged(cur_task, reinterpret_cast<void*>(clear_mask), reinterpret_cast<void*>(timeout_ms), EPM_Task_WaitNotify_Priv);
+	if ( res != ResultOk )
+		return res;
+	
+	if ( cur_task->m_unblock_reason == UnblockReasonTimeout )
+		return ResultTimeout;
+
+	value = cur_task->m_notify_recv;
+	return ResultOk;
+}
+
+Result Task::WaitNotify_Priv(Task * task, uint32_t clear_mask, uint32_t timeout_ms)
+{
+	CriticalSection _cs_;
+	MACS_TRACE(TaskWaitNotify, Trace::Id(task), 0);
+
+	task->m_notify_clear = clear_mask;
+	if ( task->m_notify_pending ) {
+		task->TakeNotify();
+		task->m_unblock_reason = UnblockReasonNone;	// по этому полю выше судят о результате операции
+		return ResultOk;
+	}
+
+	if ( timeout_ms == 0 ) 
+		return ResultTimeout;
+	
+	// флаг ожидания сбрасывается ядром при любой разблокировке задачи
+	task->m_notify_waiting = true;
+	Result res = BlockCurrentTask_Priv(& Sch(), timeout_ms, nullptr);
+	if ( res != ResultOk )
+		task->m_notify_waiting = false;
+	return res;
+}
+#endif
+
 void Task::SetBlockSync(SyncObject * sync_obj)
 {
 	_ASSERT(sync_obj);
@@ -215,6 +364,102 @@ void SyncObject::OnDeleteTask(Task * task)
 	TaskSyncList::Del(m_blocked_task_list, task);
 }
 
+#if MACS_WAIT_MULTIPLE
+void SyncObject::NotifySelect(bool take, bool all)
+{
+	while ( m_select_list ) {
+		SelectWait * wait = m_select_list->m_wait;
+		if ( take && ! TryTake(wait->m_task) )
+			break;
+
+		wait->m_fired = static_cast<int>(m_select_list - wait->m_nodes);
+		wait->Unlink();	// в том числе из списка данного объекта
+		Sch().UnblockTask(wait->m_task);
+
+		if ( ! all )
+			break;
+	}
+}
+
+void SelectWait::Link()
+{
+	const Task::Priority prior = m_task->GetPriority();
+	for ( size_t i = 0; i < m_qty; ++ i ) {
+		// порядок по убыванию приоритета, среди равных - в порядке поступления
+		SelectNode ** link = & m_objs[i]->m_select_list;
+		while ( * link && (* link)->m_wait->m_task->GetPriority() >= prior )
+			link = & (* link)->m_next;
+
+		m_nodes[i].m_wait = this;
+		m_nodes[i].m_next = * link;
+		* link = & m_nodes[i];
+	}
+	m_linked = true;
+}
+
+void SelectWait::Unlink()
+{
+	if ( ! m_linked )
+		return;
+
+	for ( size_t i = 0; i < m_qty; ++ i ) {
+		SelectNode ** link = & m_objs[i]->m_select_list;
+		while ( * link && * link != & m_nodes[i] )
+			link = & (* link)->m_next;
+		if ( * link )
+			* link = m_nodes[i].m_next;
+	}
+	m_linked = false;
+}
+
+Result WaitMultiple(SyncObject * const objs[], size_t qty, size_t & fired, uint32_t timeout_ms)
+{
+	if ( ! Sch().IsStarted() ) 
+		return ResultErrorInvalidState;
+
+	if ( System::IsInInterrupt() ) 
+		return ResultErrorInterruptNotSupported;
+
+	if ( ! objs || qty == 0 || qty > MACS_WAIT_MULTIPLE_MAX )
+		return ResultErrorInvalidArgs;
+
+	SelectWait wait(objs, qty);
+	Result res = System::IsInPrivOrIrq() ? WaitMultiple_Priv(& wait, timeout_ms) 
+	                                     : SvcExecPrivileged(& wait, reinterpret_cast<void*>(timeout_ms), NULL, EPM_WaitMultiple_Priv);
+	if ( res != ResultOk )
+		return res;
+
+	if ( wait.m_fired < 0 )
+		return ResultTimeout;
+
+	fired = static_cast<size_t>(wait.m_fired);
+	return ResultOk;
+}
+
+Result WaitMultiple_Priv(SelectWait * wait, uint32_t timeout_ms)
+{
+	CriticalSection _cs_;
+
+	Task * task = Sch().GetCurrentTask();
+	wait->m_task = task;
+	for ( size_t i = 0; i < wait->m_qty; ++ i ) {
+		if ( wait->m_objs[i]->TryTake(task) ) {
+			wait->m_fired = static_cast<int>(i);
+			return ResultOk;
+		}
+	}
+
+	if ( timeout_ms == 0 ) 
+		return ResultTimeout;
+
+	wait->Link();
+	Result res = BlockCurrentTask_Priv(& Sch(), timeout_ms, wait);
+	if ( res != ResultOk )
+		wait->Unlink();
+	return res;
+}
+#endif
+
 TaskIrq::TaskIrq(const char* name) : 
 	Task(name) 
 { 
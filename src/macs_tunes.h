@@ -29,7 +29,10 @@
 #endif
 
 #ifndef MACS_TASK_NAME_LENGTH
-	#define MACS_TASK_NAME_LENGTH   -1       ///< Длина имени задачи.	При значении -1 имя хранится в динамической памяти. При значении 0 имена не используются.
+	#define MACS_TASK_NAME_LENGTH   -1       ///< Длина имени задачи.	При значении -1 имя хранится в динамической памяти, при -2 хранится только указатель на строку имени (строка должна существовать все время жизни задачи). При значении 0 имена не используются.
+#endif
+#ifndef MACS_STATIC_SYS_TASKS
+	#define MACS_STATIC_SYS_TASKS   1        ///< Системные задачи (бездействия, программных таймеров) вместе со стеками размещаются статически, а не в динамической памяти.
 #endif
 
 #ifndef MACS_MAX_TASK_PRIORITY
@@ -44,16 +47,65 @@
 	#define MACS_PROFILING_ENABLED   0     ///< В процессе работы может измеряться время выполнения разных операций. Снижает производительность. 
 #endif
 
+#ifndef MACS_USE_TRACE
+	#define MACS_USE_TRACE           0     ///< Ядро записывает события планировщика в кольцевой буфер трассировки. Отключает MACS_SYNC_FAST_PATH.
+#endif
+#ifndef MACS_TRACE_SIZE
+	#define MACS_TRACE_SIZE          256u  ///< Размер буфера трассировки в записях (степень двойки, запись - 8 байт).
+#endif
+
 #ifndef MACS_MEM_STATISTICS
 	#define MACS_MEM_STATISTICS      0     ///< Распределитель памяти собирает статистику во время работы.
 #endif
 #ifndef MACS_MEM_WIPE
 	#define MACS_MEM_WIPE            0     ///< Распределитель памяти затирает освобождаемую память мусором.
 #endif
+#ifndef MACS_MEM_TLSF
+	#define MACS_MEM_TLSF            1     ///< Куча размером HEAP_SIZE управляется распределителем TLSF (O(1)) вместо malloc/free библиотеки C.
+#endif
+#ifndef MACS_MEM_REGION_QTY
+	#define MACS_MEM_REGION_QTY      4     ///< Максимальное количество областей динамической памяти (с учетом основной кучи).
+#endif
+#ifndef MACS_MEM_STACK_FAST
+	#define MACS_MEM_STACK_FAST      0     ///< Размещение стеков задач в быстрой памяти (MemPolicyFast), например, в CCM. При включении буферы DMA на стеке недопустимы.
+#endif
+#ifndef MACS_MEM_SIZE_CLASSES
+	#define MACS_MEM_SIZE_CLASSES    MACS_MEM_TLSF  ///< Блоки до 256 байт выделяются из пулов по классам размеров, пополняемых из кучи (требует MACS_MEM_TLSF).
+#endif
+#ifndef MACS_MEM_CLASS_REFILL
+	#define MACS_MEM_CLASS_REFILL    256u  ///< Объем памяти в байтах, запрашиваемый из кучи при пополнении класса размеров.
+#endif
+#ifndef MACS_MEM_TASK_ARENA
+	#define MACS_MEM_TASK_ARENA      0     ///< Задача может выделять память операторами new из собственной арены (Task::CreateArena), требует MACS_MEM_TLSF.
+#endif
+#ifndef MACS_MEM_PROFILE
+	#define MACS_MEM_PROFILE         0     ///< Живые блоки динамической памяти учитываются по месту вызова (адресу возврата), см. MemoryManager::GetProfile.
+#endif
+#ifndef MACS_MEM_PROFILE_SITES
+	#define MACS_MEM_PROFILE_SITES   32u   ///< Размер таблицы мест вызова профилировщика памяти (последний элемент собирает не поместившиеся места).
+#endif
 #ifndef MACS_MEM_ON_PAUSE
 	#define MACS_MEM_ON_PAUSE        1     ///< При работе с динамической памятью используется механизм паузы планировщика вместо SpinLock.
 #endif
 
+#ifndef MACS_SYNC_FAST_PATH
+	#define MACS_SYNC_FAST_PATH      (! MACS_USE_TRACE) ///< Захват свободного мьютекса и семафора выполняется без обращения к ядру (без SVC). Несовместим с MACS_USE_TRACE.
+#endif
+
+#ifndef MACS_IRQ_QTY
+	#define MACS_IRQ_QTY             240   ///< Количество внешних прерываний контроллера (размер таблицы обработчиков TaskIrq).
+#endif
+#ifndef MACS_VIRT_IRQ_QTY
+	#define MACS_VIRT_IRQ_QTY        16    ///< Количество виртуальных прерываний, начиная с FIRST_VIRT_IRQ.
+#endif
+
+#ifndef MACS_IRQ_POST
+	#define MACS_IRQ_POST            1     ///< Операции ядра, вызванные из прерываний (Semaphore::Signal, Event::Raise, Task::Notify), выполняются отложенно в PendSV.
+#endif
+#ifndef MACS_IRQ_POST_QTY
+	#define MACS_IRQ_POST_QTY        32u   ///< Размер очереди отложенных операций (степень двойки). При переполнении операция выполняется в прерывании.
+#endif
+
 #ifndef MACS_IRQ_FAST_SWITCH
 	#define MACS_IRQ_FAST_SWITCH     1     ///< Переключение контекста после паузы происходит немедленно
 #endif
@@ -62,6 +114,13 @@
 	#define MACS_SLEEP_ON_IDLE       0     ///< В задаче холостого хода процессор переводится в режим низкого энергопотребления.
 #endif
 
+#ifndef MACS_TICKLESS_IDLE
+	#define MACS_TICKLESS_IDLE       0     ///< В задаче холостого хода системный таймер останавливается до ближайшего пробуждения задач.
+#endif
+#ifndef MACS_TICKLESS_MIN_TICKS
+	#define MACS_TICKLESS_MIN_TICKS  2u    ///< Минимальное количество тиков простоя, при котором системный таймер останавливается.
+#endif
+
 #ifndef MACS_PRINTF_ALLOWED
 	#define MACS_PRINTF_ALLOWED      0     ///< Разрешает использовать printf из ядра. В реальных приложениях может приводить к краху системы.
 #endif
@@ -82,6 +141,41 @@
 	#define MACS_USE_CLOCK         	 0  ///< Использование надежных меток времени. 
 #endif
 
+#ifndef MACS_CPU_LOAD_WINDOW
+	#define MACS_CPU_LOAD_WINDOW     1u ///< Окно расчета загрузки процессора задачами (в секундах, не более 2^32 тактов).
+#endif
+
 #ifndef MACS_USE_LOG
 	#define MACS_USE_LOG             0  ///< Использование журнала событий. 
 #endif
+
+#ifndef MACS_TASK_NOTIFY
+	#define MACS_TASK_NOTIFY         1  ///< Использование уведомлений задач (Task::Notify/Task::WaitNotify).
+#endif
+
+#ifndef MACS_EVENT_GROUPS
+	#define MACS_EVENT_GROUPS        1  ///< Использование групп событий (EventGroup).
+#endif
+
+#ifndef MACS_WAIT_MULTIPLE
+	#define MACS_WAIT_MULTIPLE       1  ///< Ожидание нескольких объектов синхронизации одной задачей (WaitMultiple).
+#endif
+#ifndef MACS_WAIT_MULTIPLE_MAX
+	#define MACS_WAIT_MULTIPLE_MAX   8  ///< Максимальное количество объектов в одном вызове WaitMultiple.
+#endif
+
+#ifndef MACS_SOFT_TIMERS
+	#define MACS_SOFT_TIMERS         0  ///< Использование программных таймеров (SoftTimer). При MACS_SOFT_TIMER_TASK добавляет задачу таймеров.
+#endif
+#ifndef MACS_SOFT_TIMER_QTY
+	#define MACS_SOFT_TIMER_QTY      32 ///< Максимальное количество одновременно запущенных программных таймеров.
+#endif
+#ifndef MACS_SOFT_TIMER_TASK
+	#define MACS_SOFT_TIMER_TASK     1  ///< Обработчики таймеров вызываются задачей таймеров (при 0 - из обработчика системного тика).
+#endif
+#ifndef MACS_SOFT_TIMER_PRIORITY
+	#define MACS_SOFT_TIMER_PRIORITY   Task::PriorityHigh         ///< Приоритет задачи таймеров.
+#endif
+#ifndef MACS_SOFT_TIMER_STACK_SIZE
+	#define MACS_SOFT_TIMER_STACK_SIZE Task::ENOUGH_STACK_SIZE    ///< Размер стека задачи таймеров (в словах).
+#endif
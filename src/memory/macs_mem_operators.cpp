@@ -6,11 +6,18 @@
 #include "macs_memory_manager.hpp"
 #include <new>
 
+#if MACS_MEM_PROFILE
+	// блок учитывается профилировщиком по месту вызова оператора, а не внутри него
+	#define ALLOCATE(size) MemoryManager::AllocateAt(size, MACS_RETURN_ADDRESS())
+#else
+	#define ALLOCATE(size) MemoryManager::Allocate(size)
+#endif
+
 #if defined(__ICCARM__) || defined(__GNUC__) || defined(__VISUALDSPVERSION__)		// IAR, GCC or VISUALDSP Compiler for C/C++
 
 void * operator new(size_t size)
 {
-	return MemoryManager::Allocate(size);
+	return ALLOCATE(size);
 }
 
 void operator delete(void * ptr)
@@ -20,7 +27,7 @@ void operator delete(void * ptr)
 
 void * operator new[](size_t size)
 {
-	return MemoryManager::Allocate(size);
+	return ALLOCATE(size);
 }
 
 void operator delete[](void * ptr)
@@ -32,7 +39,7 @@ void operator delete[](void * ptr)
 
 void * operator new(size_t size, const std::nothrow_t &) throw()
 {
-	return MemoryManager::Allocate(size);
+	return ALLOCATE(size);
 }
 
 void operator delete(void * ptr, const std::nothrow_t &) throw()
@@ -42,7 +49,7 @@ void operator delete(void * ptr, const std::nothrow_t &) throw()
 
 void * operator new(size_t size) throw(std::bad_alloc)
 {
-	return MemoryManager::Allocate(size);
+	return ALLOCATE(size);
 }
 
 void operator delete(void * ptr) throw ()
@@ -52,7 +59,7 @@ void operator delete(void * ptr) throw ()
 
 void * operator new[](size_t size, const std::nothrow_t &) throw()
 {
-	return MemoryManager::Allocate(size);
+	return ALLOCATE(size);
 }
 
 void operator delete[](void * ptr, const std::nothrow_t &) throw()
@@ -62,7 +69,7 @@ void operator delete[](void * ptr, const std::nothrow_t &) throw()
 
 void * operator new[](size_t size) throw(std::bad_alloc)
 {
-	return MemoryManager::Allocate(size);
+	return ALLOCATE(size);
 }
 
 void operator delete[](void * ptr) throw()
@@ -9,6 +9,9 @@
 #include "macs_memory_manager.hpp"
 #include "macs_scheduler.hpp"
 #include "macs_task.hpp"
+#if MACS_MEM_TLSF
+	#include "macs_tlsf.hpp"
+#endif
 
 #if MACS_USE_MPU
 void MPU_Init()
@@ -46,12 +49,136 @@ bool MemoryManager::s_init_flag = false;
 size_t MemoryManager::s_heap_size = 0;
 byte MemoryManager::s_lock = 0;
 
+#if MACS_MEM_TLSF
+static uint64_t heapMem[System::HEAP_SIZE / sizeof(uint64_t)];	// uint64_t - для выравнивания на 8 байт
+
+// Область динамической памяти со своей кучей
+struct HeapRegion
+{
+	const char * name;
+	byte *       beg;
+	byte *       end;
+	uint         attrs;
+	TlsfHeap     heap;
+};
+static HeapRegion regions[MACS_MEM_REGION_QTY];
+static volatile int regionQty;
+#endif
+
+#if MACS_MEM_SIZE_CLASSES
+	#if ! MACS_MEM_TLSF
+		#error MACS_MEM_SIZE_CLASSES requires MACS_MEM_TLSF
+	#endif
+// Размеры блоков классов и номер класса для каждого размера, округленного до 8 байт
+static const size_t classSizes[] = { 8, 16, 24, 32, 48, 64, 96, 128, 192, 256 };
+static const size_t CLASS_QTY = countof(classSizes);
+static const size_t CLASS_SIZE_MAX = 256;
+static const byte classIndex[CLASS_SIZE_MAX / 8 + 1] = {
+	0, 0, 1, 2, 3, 4, 4, 5, 5,
+	6, 6, 6, 6, 7, 7, 7, 7,
+	8, 8, 8, 8, 8, 8, 8, 8,
+	9, 9, 9, 9, 9, 9, 9, 9
+};
+static const uint CLASS_TAG_SHIFT = 3;	// номер класса располагается выше флагов заголовка TlsfHeap
+#endif
+
+#if MACS_MEM_TASK_ARENA
+	#if ! MACS_MEM_TLSF
+		#error MACS_MEM_TASK_ARENA requires MACS_MEM_TLSF
+	#endif
+// Блок арены задачи помечается в слове перед данными признаком FOREIGN_TAG со всеми старшими битами:
+// такого номера класса размеров нет, а в заголовке блока кучи этот бит сброшен
+static const size_t ARENA_TAG = ~ (size_t) (TlsfHeap::FOREIGN_TAG - 1);
+
+static inline bool IsArenaBlock(const void * ptr) { return static_cast<const size_t *>(ptr)[-1] == ARENA_TAG; }
+#endif
+
 #if MACS_MEM_STATISTICS
 size_t MemoryManager::s_cur_heap_size = 0;
 size_t MemoryManager::s_peak_heap_size = 0;
+#if MACS_MEM_SIZE_CLASSES
+size_t MemoryManager::s_class_pool_size = 0;
+#endif
 	#if MACS_DEBUG
 static volatile long dbgCurHeapSize, dbgCurHeapChange; // Статические переменные для отладки
 	#endif
+static size_t sizeHist[MemoryManager::SIZE_HIST_QTY];
+static MemoryManager::LatencyStat allocLatency, freeLatency;
+static size_t oomRetries;
+
+// Вызывается внутри блокировки кучи. Непривилегированная задача читает счетчик тактов через SVC,
+// поэтому ее замер включает время вызова ядра, зато учитывается каждая операция.
+static void AddLatency(MemoryManager::LatencyStat & stat, ulong start)
+{
+	const uint32_t ticks = System::AskCurCpuTick() - start;
+	if ( ! stat.count || ticks < stat.min )
+		stat.min = ticks;
+	if ( ticks > stat.max )
+		stat.max = ticks;
+	stat.sum += ticks;
+	++ stat.count;
+}
+#endif
+
+#if MACS_MEM_PROFILE
+// Место вызова запоминается при выделении блока: адрес возврата в функцию, вызвавшую Allocate (или оператор new)
+	#define CALL_SITE() MACS_RETURN_ADDRESS()
+
+// Заголовок профилировщика располагается перед данными блока и сохраняет их выравнивание на 8 байт
+struct ProfileHdr
+{
+	uint32_t site;	// номер места вызова в таблице
+	uint32_t size;	// запрошенный размер
+};
+static const size_t PROFILE_HDR_SIZE = sizeof(ProfileHdr);
+
+// Таблица мест вызова; элементы не удаляются, поэтому номер места в заголовке блока остается действительным.
+// Последний элемент (site == nullptr) собирает места, не поместившиеся в таблицу.
+static MemoryManager::ProfileSite profileSites[MACS_MEM_PROFILE_SITES];
+static size_t profileSiteQty;
+
+static uint32_t ProfileSiteIndex(const void * site)
+{
+	for ( size_t i = 0; i < profileSiteQty; ++ i )
+		if ( profileSites[i].site == site )
+			return i;
+	if ( profileSiteQty + 1 >= MACS_MEM_PROFILE_SITES )
+		return MACS_MEM_PROFILE_SITES - 1;
+	profileSites[profileSiteQty].site = site;
+	return profileSiteQty ++;
+}
+
+// Учет выделенного блока, возвращает указатель на данные после заголовка
+static void * ProfileTrack(void * ptr, size_t size, const void * site)
+{
+	if ( ! ptr )
+		return nullptr;
+
+	ProfileHdr * hdr = static_cast<ProfileHdr *>(ptr);
+	PauseSection _ps_;
+	hdr->site = ProfileSiteIndex(site);
+	hdr->size = size;
+	MemoryManager::ProfileSite & ps = profileSites[hdr->site];
+	++ ps.blocks;
+	ps.bytes += size;
+	++ ps.allocs;
+	return hdr + 1;
+}
+
+// Снятие блока с учета, возвращает указатель на начало блока
+static void * ProfileRelease(void * ptr)
+{
+	ProfileHdr * hdr = static_cast<ProfileHdr *>(ptr) - 1;
+	_ASSERT(hdr->site < MACS_MEM_PROFILE_SITES);
+	PauseSection _ps_;
+	MemoryManager::ProfileSite & ps = profileSites[hdr->site];
+	-- ps.blocks;
+	ps.bytes -= hdr->size;
+	return hdr;
+}
+#else
+	#define CALL_SITE() nullptr
+static const size_t PROFILE_HDR_SIZE = 0;
 #endif
 
 void MemoryManager::LogAllocatedSize()
@@ -61,7 +188,123 @@ void MemoryManager::LogAllocatedSize()
 #endif
 }
 
-void * MemoryManager::MemAlloc(size_t size)
+#if MACS_MEM_TLSF
+
+void MemoryManager::InitHeap()
+{
+	if ( s_heap_size > sizeof(heapMem) )
+		s_heap_size = sizeof(heapMem);
+	regionQty = 0;
+	AddRegion("main", heapMem, s_heap_size, MemAttrDma);
+	System::InitHeapRegions();
+}
+
+int MemoryManager::AddRegion(const char * name, void * mem, size_t size, uint attrs)
+{
+	if ( ! s_init_flag )
+		Initialize<HEAP_SIZE>();
+
+#if ! MACS_MEM_ON_PAUSE
+	LockGuard lock(heapLock);
+#endif
+#if MACS_MEM_ON_PAUSE
+	PauseSection _ps_;
+#endif
+	HeapLocker _hl_;
+
+	const int num = regionQty;
+	if ( num >= (int) MACS_MEM_REGION_QTY || ! mem )
+		return -1;
+
+	HeapRegion & reg = regions[num];
+	reg.heap.Init(mem, size);
+	if ( ! reg.heap.IsReady() )
+		return -1;
+	reg.name = name;
+	reg.beg = static_cast<byte *>(mem);
+	reg.end = reg.beg + size;
+	reg.attrs = attrs;
+	regionQty = num + 1;	// область становится доступной после заполнения
+	return num;
+}
+
+int MemoryManager::FindRegion(const char * name)
+{
+	for ( int i = 0; i < regionQty; ++ i )
+		if ( ! strcmp(regions[i].name, name) )
+			return i;
+	return -1;
+}
+
+void * MemoryManager::AllocateInRegion(size_t size, int region)
+{
+	if ( ! s_init_flag )
+		Initialize<HEAP_SIZE>();
+
+	if ( region < 0 || region >= regionQty )
+		return nullptr;
+
+	return AllocateBlock(size, region, MemPolicyDefault, CALL_SITE());
+}
+
+void * MemoryManager::MemAlloc(size_t size, int region, MemPolicy policy)
+{
+	void * ptr = nullptr;
+	if ( region >= 0 )
+		ptr = regions[region].heap.Alloc(size);
+	else if ( policy == MemPolicyDefault )
+		ptr = regions[0].heap.Alloc(size);
+	else {
+		// области с требуемым свойством - в порядке регистрации, затем (кроме DMA) основная куча
+		for ( int i = 0; ! ptr && i < regionQty; ++ i )
+			if ( regions[i].attrs & policy )
+				ptr = regions[i].heap.Alloc(size);
+		if ( ! ptr && policy != MemPolicyDma )
+			ptr = regions[0].heap.Alloc(size);
+	}
+#if MACS_MEM_STATISTICS
+	if ( ! ptr )
+		return nullptr;
+	// учитывается фактический размер блока, который может превышать запрошенный
+	s_cur_heap_size += TlsfHeap::BlockSize(ptr);
+#if MACS_DEBUG
+	dbgCurHeapChange = TlsfHeap::BlockSize(ptr);
+	dbgCurHeapSize = s_cur_heap_size;
+#endif
+	if ( s_cur_heap_size > s_peak_heap_size )
+		s_peak_heap_size = s_cur_heap_size;
+#endif
+	return ptr;
+}
+
+void MemoryManager::MemFree(void * ptr)
+{
+#if MACS_MEM_STATISTICS || MACS_MEM_WIPE
+	const size_t size = TlsfHeap::BlockSize(ptr);
+#endif
+#if MACS_MEM_STATISTICS
+	s_cur_heap_size -= size;
+#if MACS_DEBUG
+	dbgCurHeapChange = - (long) size;
+	dbgCurHeapSize = s_cur_heap_size;
+#endif
+#endif
+#if MACS_MEM_WIPE
+	Wipe(ptr, size);
+#endif
+	for ( int i = 0; i < regionQty; ++ i ) {
+		if ( ptr >= regions[i].beg && ptr < regions[i].end ) {
+			regions[i].heap.Free(ptr);
+			return;
+		}
+	}
+	_ASSERT(false);
+}
+
+#else	// MACS_MEM_TLSF
+
+// Без TLSF области не поддерживаются, вся память выделяется библиотекой C
+void * MemoryManager::MemAlloc(size_t size, int, MemPolicy)
 {
 #if MACS_MEM_STATISTICS
 	if ( s_cur_heap_size + size > s_heap_size )
@@ -101,7 +344,63 @@ void MemoryManager::MemFree(void * ptr)
 #endif
 }
 
+#endif	// MACS_MEM_TLSF
+
+void * MemoryManager::HeapAlloc(size_t size, int region, MemPolicy policy)
+{
+#if ! MACS_MEM_ON_PAUSE
+	LockGuard lock(heapLock);
+#endif
+#if MACS_MEM_ON_PAUSE
+	PauseSection _ps_;
+#endif
+	HeapLocker _hl_;
+#if MACS_MEM_STATISTICS
+	const ulong start = System::AskCurCpuTick();
+	void * ptr = MemAlloc(size, region, policy);
+	AddLatency(allocLatency, start);
+	return ptr;
+#else
+	return MemAlloc(size, region, policy);
+#endif
+}
+
+void MemoryManager::HeapFree(void * ptr)
+{
+#if ! MACS_MEM_ON_PAUSE
+	LockGuard lock(heapLock);
+#endif
+#if MACS_MEM_ON_PAUSE
+	PauseSection _ps_;
+#endif
+	HeapLocker _hl_;
+#if MACS_MEM_STATISTICS
+	const ulong start = System::AskCurCpuTick();
+	MemFree(ptr);
+	AddLatency(freeLatency, start);
+#else
+	MemFree(ptr);
+#endif
+}
+
 void* MemoryManager::Allocate(size_t size)
+{
+	return AllocateBlock(size, -1, MemPolicyDefault, CALL_SITE());
+}
+
+void * MemoryManager::Allocate(size_t size, MemPolicy policy)
+{
+	return AllocateBlock(size, -1, policy, CALL_SITE());
+}
+
+#if MACS_MEM_PROFILE
+void * MemoryManager::AllocateAt(size_t size, const void * site)
+{
+	return AllocateBlock(size, -1, MemPolicyDefault, site);
+}
+#endif
+
+void * MemoryManager::AllocateBlock(size_t size, int region, MemPolicy policy, const void * site)
 {
 	if ( ! s_init_flag )
 		Initialize<HEAP_SIZE>();
@@ -109,24 +408,44 @@ void* MemoryManager::Allocate(size_t size)
 	if ( size == 0 )
 		return nullptr;
 
-#if ! MACS_MEM_ON_PAUSE
-	LockGuard lock(heapLock);
+	const size_t block_size = size + PROFILE_HDR_SIZE;
+	void * ptr = nullptr;
+#if MACS_MEM_TASK_ARENA
+	if ( region < 0 && policy == MemPolicyDefault )
+		ptr = ArenaAlloc(block_size);
+#endif
+#if MACS_MEM_SIZE_CLASSES
+	if ( ! ptr && region < 0 && policy == MemPolicyDefault && block_size <= CLASS_SIZE_MAX )
+		ptr = ClassAlloc(block_size);
 #endif
+	if ( ! ptr )
+		ptr = AllocateFrom(block_size, region, policy);
+#if MACS_MEM_PROFILE
+	ptr = ProfileTrack(ptr, size, site);
+#endif
+#if MACS_MEM_STATISTICS
+	CountRequest(size);
+#endif
+	return ptr;
+}
+
+void * MemoryManager::AllocateFrom(size_t size, int region, MemPolicy policy)
+{
+	if ( size == 0 )
+		return nullptr;
 
 	void * ptr;
 	for(;;) {
-		{
-#if MACS_MEM_ON_PAUSE
-			PauseSection _ps_;
-#endif
-			{
-				HeapLocker _hl_;
-				ptr = MemAlloc(size);
-			}
-		}
+		ptr = HeapAlloc(size, region, policy);
 		if ( ptr )
 			break;
 
+#if MACS_MEM_STATISTICS
+		{
+			PauseSection _ps_;
+			++ oomRetries;
+		}
+#endif
 		ALARM_ACTION act = MACS_ALARM(AR_OUT_OF_MEMORY);
 		if ( act == AA_CONTINUE )
 			continue;
@@ -146,21 +465,251 @@ void MemoryManager::Deallocate(void* ptr)
 	if ( ! ptr )
 		return;
 
+#if MACS_MEM_PROFILE
+	ptr = ProfileRelease(ptr);
+#endif
+#if MACS_MEM_TASK_ARENA
+	if ( IsArenaBlock(ptr) )
+		;	// память блока возвращается вместе с ареной
+	else
+#endif
+#if MACS_MEM_SIZE_CLASSES
+	if ( TlsfHeap::IsForeign(ptr) )
+		ClassFree(ptr);
+	else
+#endif
+		HeapFree(ptr);
+}
+
+#if MACS_MEM_STATISTICS
+
+void MemoryManager::CountRequest(size_t size)
+{
+	PauseSection _ps_;
+	// интервалы: до 16 байт, до 32, ..., последний - все остальные
+	const size_t ind = size <= 16 ? 0 : (31 - MACS_CLZ(size - 1)) - 3;
+	++ sizeHist[MIN(ind, SIZE_HIST_QTY - 1)];
+}
+
+size_t MemoryManager::MaxHeapSize()
+{
+#if MACS_MEM_TLSF
+	size_t size = 0;
+	for ( int i = 0; i < regionQty; ++ i )
+		size += regions[i].end - regions[i].beg;
+	return size;
+#else
+	return s_heap_size;
+#endif
+}
+
+void MemoryManager::GetStat(MemStat & stat)
+{
+	if ( ! s_init_flag )
+		Initialize<HEAP_SIZE>();
+
+	stat.heap_size = MaxHeapSize();
+	stat.free_blocks = stat.free_size = stat.largest_free = 0;
+	{
 #if ! MACS_MEM_ON_PAUSE
-	LockGuard lock(heapLock);
+		LockGuard lock(heapLock);
 #endif
+		PauseSection _ps_;
+#if MACS_MEM_TLSF
+		for ( int i = 0; i < regionQty; ++ i ) {
+			const TlsfHeap & heap = regions[i].heap;
+			stat.free_blocks += heap.GetFreeBlocks();
+			stat.free_size += heap.GetFreeSize();
+			stat.largest_free = MAX(stat.largest_free, heap.GetLargestFree());
+		}
+#endif
+		stat.cur_size = s_cur_heap_size;
+		stat.peak_size = s_peak_heap_size;
+#if MACS_MEM_SIZE_CLASSES
+		stat.pool_size = s_class_pool_size;
+#else
+		stat.pool_size = 0;
+#endif
+		stat.oom_retries = oomRetries;
+		memcpy(stat.size_hist, sizeHist, sizeof(sizeHist));
+		stat.alloc_latency = allocLatency;
+		stat.free_latency = freeLatency;
+	}
+}
+
+void MemoryManager::ResetStat()
+{
+	PauseSection _ps_;
+	memset(sizeHist, 0, sizeof(sizeHist));
+	memset(& allocLatency, 0, sizeof(allocLatency));
+	memset(& freeLatency, 0, sizeof(freeLatency));
+	oomRetries = 0;
+}
 
+#endif	// MACS_MEM_STATISTICS
+
+#if MACS_MEM_PROFILE
+
+size_t MemoryManager::GetProfile(ProfileSite * sites, size_t max_qty, bool by_allocs)
+{
+	size_t qty = 0;
+	PauseSection _ps_;
+	// выбор наибольших вставкой в упорядоченный массив: таблица мест вызова невелика
+	loop ( size_t, index, MACS_MEM_PROFILE_SITES ) {
+		const ProfileSite & ps = profileSites[index];
+		if ( ! ps.allocs && ! ps.blocks )
+			continue;
+
+		const size_t key = by_allocs ? ps.allocs : ps.bytes;
+		size_t pos = qty;
+		while ( pos > 0 && (by_allocs ? sites[pos - 1].allocs : sites[pos - 1].bytes) < key ) {
+			if ( pos < max_qty )
+				sites[pos] = sites[pos - 1];
+			-- pos;
+		}
+		if ( pos < max_qty ) {
+			sites[pos] = ps;
+			if ( qty < max_qty )
+				++ qty;
+		}
+	}
+	return qty;
+}
+
+void MemoryManager::ResetProfile()
+{
+	PauseSection _ps_;
+	loop ( size_t, index, MACS_MEM_PROFILE_SITES )
+		profileSites[index].allocs = 0;
+}
+
+#endif	// MACS_MEM_PROFILE
+
+#if MACS_MEM_TASK_ARENA
+
+void * MemoryManager::ArenaAlloc(size_t size)
+{
+	// обработчики прерываний и вызовы ядра используют кучу
+	if ( System::IsInInterrupt() )
+		return nullptr;
+
+	Task * task = Task::GetCurrent();
+	if ( ! task || ! task->IsArenaUsed() )
+		return nullptr;
+
+	// блок арены, как и блок класса размеров, начинается заголовком размером TlsfHeap::Overhead();
+	// если арена заполнена, блок выделяется из кучи
+	byte * blk = static_cast<byte *>(task->GetArena()->Alloc(size + TlsfHeap::Overhead()));
+	if ( ! blk )
+		return nullptr;
+
+	void * ptr = blk + TlsfHeap::Overhead();
+	static_cast<size_t *>(ptr)[-1] = ARENA_TAG;
+	return ptr;
+}
+
+#endif	// MACS_MEM_TASK_ARENA
+
+#if MACS_MEM_SIZE_CLASSES
+
+// Класс размеров - пул блоков одного размера со счетчиками. Блок пула начинается заголовком
+// размером TlsfHeap::Overhead(), последнее слово которого хранит номер класса с признаком
+// FOREIGN_TAG, поэтому при освобождении блок класса отличается от блока кучи без поиска.
+struct SizeClass
+{
+	MemoryPool pool;
+	size_t hits;
+	size_t misses;
+
+	SizeClass() : hits(0), misses(0) {}
+};
+
+static SizeClass * Classes()
+{
+	// классы создаются при первом обращении: operator new может быть вызван
+	// до конструкторов статических объектов
+	static SizeClass classes[CLASS_QTY];
+	return classes;
+}
+
+static inline size_t * ClassTag(void * ptr) { return static_cast<size_t *>(ptr) - 1; }
+
+size_t MemoryManager::SizeClassQty()
+{
+	return CLASS_QTY;
+}
+
+bool MemoryManager::GetSizeClassInfo(size_t cls, SizeClassInfo & info)
+{
+	if ( cls >= CLASS_QTY )
+		return false;
+
+	const SizeClass & sc = Classes()[cls];
+	PauseSection _ps_;
+	info.block_size = classSizes[cls];
+	info.hits = sc.hits;
+	info.misses = sc.misses;
+	info.blocks_total = sc.pool.GetTotalBlocksQty();
+	info.blocks_free = sc.pool.GetFreeBlocksQty();
+	return true;
+}
+
+// В статистике занятой памяти учитываются выданные блоки классов, а не порции пополнения пулов:
+// порция переводится из занятой памяти кучи в память пулов, которая в кучу не возвращается.
+void * MemoryManager::ClassAlloc(size_t size)
+{
+	const size_t cls = classIndex[(size + 7) >> 3];
+	SizeClass & sc = Classes()[cls];
+	const size_t blk_size = classSizes[cls] + TlsfHeap::Overhead();
+
+	byte * blk;
 	{
-#if MACS_MEM_ON_PAUSE
 		PauseSection _ps_;
+		blk = (byte *) sc.pool.AllocBlock();
+		if ( blk )
+			++ sc.hits;
+		else {
+			++ sc.misses;
+			// класс пополняется сразу несколькими блоками; если куча не может выделить их,
+			// блок будет выделен из кучи напрямую
+			const size_t qty = MAX(MACS_MEM_CLASS_REFILL / blk_size, 1u);
+			void * mem = HeapAlloc(qty * blk_size);
+			if ( ! mem )
+				return nullptr;
+#if MACS_MEM_STATISTICS
+			s_cur_heap_size -= TlsfHeap::BlockSize(mem);
+			s_class_pool_size += TlsfHeap::BlockSize(mem);
 #endif
-		{
-			HeapLocker _hl_;
-			MemFree(ptr);
+			sc.pool.Extend(qty, mem, blk_size);
+			blk = (byte *) sc.pool.AllocBlock();
 		}
+#if MACS_MEM_STATISTICS
+		s_cur_heap_size += blk_size;
+		if ( s_cur_heap_size > s_peak_heap_size )
+			s_peak_heap_size = s_cur_heap_size;
+#endif
+	}
+
+	void * ptr = blk + TlsfHeap::Overhead();
+	* ClassTag(ptr) = TlsfHeap::FOREIGN_TAG | (cls << CLASS_TAG_SHIFT);
+	return ptr;
+}
+
+void MemoryManager::ClassFree(void * ptr)
+{
+	const size_t cls = * ClassTag(ptr) >> CLASS_TAG_SHIFT;
+	_ASSERT(cls < CLASS_QTY);
+#if MACS_MEM_STATISTICS
+	{
+		PauseSection _ps_;
+		s_cur_heap_size -= classSizes[cls] + TlsfHeap::Overhead();
 	}
+#endif
+	Classes()[cls].pool.FreeBlock(static_cast<byte *>(ptr) - TlsfHeap::Overhead());
 }
 
+#endif	// MACS_MEM_SIZE_CLASSES
+
 ////////////////////////////////////////////////////////////////
 
 MemoryPool::MemoryPool(size_t block_size, size_t block_total, void * mem)
@@ -169,6 +718,9 @@ MemoryPool::MemoryPool(size_t block_size, size_t block_total, void * mem)
 	_ASSERT(block_total == 0 || block_size != 0);
 	m_block_size = block_size;
 	m_block_used = 0;
+#if MACS_MEM_STATISTICS
+	m_block_peak = 0;
+#endif
 	m_is_alien_mem = false;
 	m_block_mem = nullptr;
 	m_free_list = nullptr;
@@ -203,9 +755,35 @@ void MemoryPool::Create(size_t block_total, void * mem, size_t block_size)
 		}
 		curr->next = nullptr;
 		m_block_used = 0;
+#if MACS_MEM_STATISTICS
+		m_block_peak = 0;
+#endif
 	}
 }
 
+void MemoryPool::Extend(size_t block_total, void * mem, size_t block_size)
+{
+	_ASSERT(! m_block_mem);
+	_ASSERT(!! mem);
+	if ( block_size )
+		m_block_size = block_size;
+	if ( block_total == 0 || m_block_size == 0 || ! IsGoodSize(m_block_size) )
+		return;
+
+	// блоки связываются в цепочку заранее, в список свободных она добавляется целиком
+	MemPoolHdr * const first = (MemPoolHdr *) mem;
+	MemPoolHdr * const last = Shift(first, block_total - 1);
+	MemPoolHdr * curr = first;
+	while ( curr < last ) {
+		MemPoolHdr * next = Shift(curr);
+		curr->next = next;
+		curr = next;
+	}
+
+	m_block_total += block_total;
+	Push(first, last);
+}
+
 void MemoryPool::Free() 
 {
 	if ( m_block_total ) {
@@ -214,18 +792,98 @@ void MemoryPool::Free()
 		m_is_alien_mem = false;
 		m_block_total = 0;
 		m_block_used = 0;
+#if MACS_MEM_STATISTICS
+		m_block_peak = 0;
+#endif
 		m_block_mem = nullptr;
 		m_free_list = nullptr;
 	}
 }
  
+// Извлечение блока из списка свободных. Вход в любое исключение сбрасывает монитор эксклюзивного
+// доступа, поэтому если между LDREX и STREX блок был извлечен и возвращен в список (ABA) прерыванием
+// или вытеснившей задачей, запись не состоится и попытка будет повторена с новой вершиной списка.
+MemoryPool::MemPoolHdr * MemoryPool::Pop()
+{
+#if MACS_MCU_CORE >= MACS_CORTEX_M3
+	MemPoolHdr * head;
+	do {
+		head = (MemPoolHdr *) MACS_LDREXW((ulong *) & m_free_list);
+		if ( ! head ) {
+			__CLREX();
+			return nullptr;
+		}
+	} while ( MACS_STREXW((ulong) head->next, (ulong *) & m_free_list) );
+	return head;
+#else
+	const uint32_t mask = System::DisableIrq();
+	MemPoolHdr * head = m_free_list;
+	if ( head )
+		m_free_list = head->next;
+	System::EnableIrq(mask);
+	return head;
+#endif
+}
+
+// Добавление цепочки блоков first..last в список свободных
+void MemoryPool::Push(MemPoolHdr * first, MemPoolHdr * last)
+{
+#if MACS_MCU_CORE >= MACS_CORTEX_M3
+	do
+		last->next = (MemPoolHdr *) MACS_LDREXW((ulong *) & m_free_list);
+	while ( MACS_STREXW((ulong) first, (ulong *) & m_free_list) );
+#else
+	const uint32_t mask = System::DisableIrq();
+	last->next = m_free_list;
+	m_free_list = first;
+	System::EnableIrq(mask);
+#endif
+}
+
+size_t MemoryPool::AtomicAdd(volatile size_t & val, size_t delta)
+{
+#if MACS_MCU_CORE >= MACS_CORTEX_M3
+	size_t res;
+	do
+		res = MACS_LDREXW((ulong *) & val) + delta;
+	while ( MACS_STREXW(res, (ulong *) & val) );
+	return res;
+#else
+	const uint32_t mask = System::DisableIrq();
+	const size_t res = (val += delta);
+	System::EnableIrq(mask);
+	return res;
+#endif
+}
+
+#if MACS_MEM_STATISTICS
+void MemoryPool::UpdatePeak(size_t used)
+{
+#if MACS_MCU_CORE >= MACS_CORTEX_M3
+	do {
+		if ( MACS_LDREXW((ulong *) & m_block_peak) >= used ) {
+			__CLREX();
+			return;
+		}
+	} while ( MACS_STREXW(used, (ulong *) & m_block_peak) );
+#else
+	const uint32_t mask = System::DisableIrq();
+	if ( m_block_peak < used )
+		m_block_peak = used;
+	System::EnableIrq(mask);
+#endif
+}
+#endif
+
 void * MemoryPool::AllocBlock()
 {
-	PauseSection _ps_;
-	void * ptr = m_free_list;
+	MemPoolHdr * ptr = Pop();
 	if ( ptr ) {
-		m_free_list = m_free_list->next;
-		++ m_block_used;
+#if MACS_MEM_STATISTICS
+		UpdatePeak(AtomicAdd(m_block_used, 1));
+#else
+		AtomicAdd(m_block_used, 1);
+#endif
 	}
 	return ptr;
 }
@@ -234,15 +892,87 @@ void MemoryPool::FreeBlock(void * pblk)
 {
 	_ASSERT(m_block_used != 0);
 	_ASSERT(!! pblk);
-	_ASSERT(pblk >= & m_block_mem[0] && pblk < & m_block_mem[m_block_total * m_block_size]);
-	_ASSERT((((byte *) pblk - m_block_mem) % m_block_size) == 0);
+	_ASSERT(! m_block_mem || (pblk >= & m_block_mem[0] && pblk < & m_block_mem[m_block_total * m_block_size]));
+	_ASSERT(! m_block_mem || (((byte *) pblk - m_block_mem) % m_block_size) == 0);
 #if MACS_MEM_WIPE
 	MemoryManager::Wipe(pblk, m_block_size);
 #endif
-	PauseSection _ps_;
-	((MemPoolHdr *) pblk)->next = m_free_list;
-	m_free_list = (MemPoolHdr *) pblk;
-	-- m_block_used;
+	AtomicAdd(m_block_used, (size_t) -1);
+	Push((MemPoolHdr *) pblk, (MemPoolHdr *) pblk);
+}
+
+////////////////////////////////////////////////////////////////
+
+Arena::Arena(size_t size, void * mem)
+{
+	m_mem = nullptr;
+	m_size = m_used = 0;
+#if MACS_MEM_STATISTICS
+	m_peak = 0;
+#endif
+	m_is_alien_mem = false;
+	if ( size )
+		Create(size, mem);
+}
+
+void Arena::Create(size_t size, void * mem)
+{
+	Free();
+	if ( ! size )
+		return;
+
+	if ( mem ) {
+		// внешняя память выравнивается на границу блоков
+		byte * beg = (byte *) (((uintptr_t) mem + ALIGN - 1) & ~ (uintptr_t) (ALIGN - 1));
+		byte * end = (byte *) (((uintptr_t) mem + size) & ~ (uintptr_t) (ALIGN - 1));
+		if ( end <= beg )
+			return;
+		m_mem = beg;
+		m_size = end - beg;
+		m_is_alien_mem = true;
+	} else {
+		m_size = (size + ALIGN - 1) & ~ (ALIGN - 1);
+		m_mem = reinterpret_cast<byte *>(new uint64_t[m_size / sizeof(uint64_t)]);
+		m_is_alien_mem = false;
+	}
+}
+
+void Arena::Free()
+{
+	if ( m_size ) {
+		if ( ! m_is_alien_mem )
+			delete [] reinterpret_cast<uint64_t *>(m_mem);
+		m_is_alien_mem = false;
+		m_mem = nullptr;
+		m_size = m_used = 0;
+#if MACS_MEM_STATISTICS
+		m_peak = 0;
+#endif
+	}
+}
+
+void * Arena::Alloc(size_t size)
+{
+	const size_t len = (size + ALIGN - 1) & ~ (ALIGN - 1);
+	if ( ! size || len > m_size - m_used )
+		return nullptr;
+
+	void * ptr = m_mem + m_used;
+	m_used += len;
+#if MACS_MEM_STATISTICS
+	if ( m_used > m_peak )
+		m_peak = m_used;
+#endif
+	return ptr;
+}
+
+void Arena::Rewind(Mark mark)
+{
+	_ASSERT(mark <= m_used);
+#if MACS_MEM_WIPE
+	MemoryManager::Wipe(m_mem + mark, m_used - mark);
+#endif
+	m_used = mark;
 }
 
 ////////////////////////////////////////////////////////////////
@@ -13,8 +13,27 @@
 
 namespace macs {
 
+/// @brief Свойства областей динамической памяти.
+enum MemAttr
+{
+	MemAttrFast = 0x1,  ///< Память без тактов ожидания (например, CCM). Может быть недоступна для DMA.
+	MemAttrDma  = 0x2,  ///< Память доступна контроллерам DMA.
+	MemAttrBulk = 0x4   ///< Память большого объема (например, внешняя SDRAM).
+};
+
+/// @brief Политика размещения блоков динамической памяти.
+enum MemPolicy
+{
+	MemPolicyDefault = 0,            ///< Основная куча.
+	MemPolicyFast = MemAttrFast,     ///< Быстрая память, при ее отсутствии или нехватке - основная куча.
+	MemPolicyDma  = MemAttrDma,      ///< Только память, доступная для DMA.
+	MemPolicyBulk = MemAttrBulk      ///< Память большого объема, при ее отсутствии или нехватке - основная куча.
+};
+
 /// @brief Распределитель динамической памяти.
-/// @details Методы распределителя памяти вызываются ядром системы и не должны использоваться напрямую из пользовательского приложения.
+/// @details Методы распределителя памяти вызываются ядром системы и не должны использоваться напрямую из пользовательского приложения,
+/// за исключением выделения памяти по политике размещения или в указанной области (например, для буферов DMA).
+/// Основная куча (HEAP_SIZE) является областью с номером 0, платформа и приложение могут добавлять другие области (AddRegion).
 class MemoryManager
 {
 private:
@@ -23,6 +42,9 @@ private:
 	static byte s_lock;
 #if MACS_MEM_STATISTICS
 	static size_t s_cur_heap_size, s_peak_heap_size;
+#if MACS_MEM_SIZE_CLASSES
+	static size_t s_class_pool_size;	// память кучи, переданная пулам классов размеров
+#endif
 #endif
 
 	class HeapLocker
@@ -43,14 +65,132 @@ public:
 
 	static void * Allocate		(size_t size); 
 	static void   Deallocate	(void	* ptr);
+
+	/// @brief Выделение памяти по политике размещения
+	/// @details Блок освобождается, как и любой другой, методом Deallocate (оператором delete).
+	/// При нехватке памяти поведение такое же, как у Allocate(size).
+	/// @param size - размер в байтах
+	/// @param policy - политика размещения
+	/// @return Указатель на блок памяти
+	static void * Allocate(size_t size, MemPolicy policy);
+
+#if MACS_MEM_TLSF
+	/// @brief Регистрация области динамической памяти
+	/// @details Области выбираются политиками размещения в порядке регистрации. Основная куча
+	/// регистрируется первой, затем платформа регистрирует свои области (System::InitHeapRegions).
+	/// @param name - имя области (строка должна существовать все время работы)
+	/// @param mem - начало области
+	/// @param size - размер области в байтах
+	/// @param attrs - свойства области (сочетание MemAttr)
+	/// @return Номер области или -1, если область не может быть добавлена
+	static int AddRegion(const char * name, void * mem, size_t size, uint attrs);
+
+	/// @brief Поиск области по имени
+	/// @return Номер области или -1, если область не найдена
+	static int FindRegion(const char * name);
+
+	/// @brief Выделение памяти в указанной области
+	/// @details При нехватке памяти поведение такое же, как у Allocate(size).
+	/// @param size - размер в байтах
+	/// @param region - номер области
+	/// @return Указатель на блок памяти
+	static void * AllocateInRegion(size_t size, int region);
+#endif
+#if MACS_MEM_PROFILE
+	/// @brief Выделение памяти с указанием места вызова
+	/// @details Используется операторами new, чтобы блок учитывался по месту вызова оператора, а не внутри него.
+	/// @param size - размер в байтах
+	/// @param site - адрес возврата в вызывающую функцию
+	/// @return Указатель на блок памяти
+	static void * AllocateAt(size_t size, const void * site);
+
+	/// @brief Статистика места вызова
+	struct ProfileSite
+	{
+		const void * site;  ///< Адрес возврата (nullptr - места вызова, не поместившиеся в таблицу)
+		size_t blocks;      ///< Количество живых блоков
+		size_t bytes;       ///< Запрошенный объем живых блоков в байтах
+		size_t allocs;      ///< Общее количество выделений
+	};
+
+	/// @brief Получить места вызова, выделяющие больше всего памяти
+	/// @param sites - массив для статистики, заполняется по убыванию объема живых блоков (или количества выделений)
+	/// @param max_qty - размер массива
+	/// @param by_allocs - упорядочить по общему количеству выделений, чтобы найти места частого выделения и освобождения
+	/// @return Количество заполненных элементов
+	static size_t GetProfile(ProfileSite * sites, size_t max_qty, bool by_allocs = false);
+
+	/// @brief Сбросить счетчики выделений мест вызова (учет живых блоков сохраняется)
+	static void ResetProfile();
+#endif
 #if MACS_MEM_WIPE
 	static void   Wipe(void	* ptr, size_t size) { memset(ptr, 0xCC, size); }
 #endif	
 
+#if MACS_MEM_SIZE_CLASSES
+	/// @brief Статистика класса размеров
+	struct SizeClassInfo
+	{
+		size_t block_size;    ///< Размер блока класса в байтах
+		size_t hits;          ///< Количество выделений из свободных блоков класса
+		size_t misses;        ///< Количество выделений, потребовавших пополнения класса из кучи
+		size_t blocks_total;  ///< Количество блоков в классе
+		size_t blocks_free;   ///< Количество свободных блоков в классе
+	};
+
+	/// @brief Получить количество классов размеров
+	static size_t SizeClassQty();
+
+	/// @brief Получить статистику класса размеров
+	/// @param cls - номер класса (от 0 до SizeClassQty() - 1), классы упорядочены по возрастанию размера блока
+	/// @param info - структура для статистики
+	/// @return false, если класса с таким номером нет
+	static bool GetSizeClassInfo(size_t cls, SizeClassInfo & info);
+#endif
+
 #if MACS_MEM_STATISTICS
-	static size_t MaxHeapSize()		{ return s_heap_size; }
+	static size_t MaxHeapSize();
 	static size_t CurHeapSize()		{ return s_cur_heap_size; }
 	static size_t PeakHeapSize()	{ return s_peak_heap_size; }
+
+	/// @brief Количество интервалов гистограммы размеров запросов
+	static const size_t SIZE_HIST_QTY = 8;
+
+	/// @brief Статистика времени выполнения операции в тактах процессора
+	/// @details Измеряется каждая операция с кучей внутри ее блокировки. Выдача блоков из классов 
+	/// размеров и арен задач не измеряется (пополнение пула класса измеряется как выделение из кучи).
+	/// Непривилегированная задача читает счетчик тактов через SVC, что увеличивает ее замеры.
+	struct LatencyStat
+	{
+		uint32_t min;       ///< Наименьшее время
+		uint32_t max;       ///< Наибольшее время
+		uint32_t count;     ///< Количество измерений
+		uint64_t sum;       ///< Суммарное время
+		uint32_t Avg() const { return count ? (uint32_t) (sum / count) : 0; }
+	};
+
+	/// @brief Статистика распределителя памяти
+	struct MemStat
+	{
+		size_t heap_size;       ///< Общий размер куч всех областей
+		size_t cur_size;        ///< Занятый объем в байтах (блоки кучи и выданные блоки классов размеров)
+		size_t peak_size;       ///< Наибольший занятый объем в байтах
+		size_t pool_size;       ///< Память кучи, закрепленная за классами размеров (в кучу не возвращается, без классов - 0)
+		size_t free_blocks;     ///< Количество свободных блоков (без TLSF - 0)
+		size_t free_size;       ///< Свободный объем в байтах (без TLSF - 0)
+		size_t largest_free;    ///< Размер наибольшего свободного блока (без TLSF - 0)
+		size_t oom_retries;     ///< Количество сигналов AR_OUT_OF_MEMORY
+		size_t size_hist[SIZE_HIST_QTY];  ///< Количество запросов по размерам: до 16 байт, до 32, ..., до 1024, больше 1024
+		LatencyStat alloc_latency;        ///< Время выделения памяти
+		LatencyStat free_latency;         ///< Время освобождения памяти
+	};
+
+	/// @brief Получить статистику распределителя памяти
+	/// @details Рост количества свободных блоков при уменьшении наибольшего из них указывает на фрагментацию кучи.
+	static void GetStat(MemStat & stat);
+
+	/// @brief Сбросить гистограмму размеров, статистику времени и счетчик AR_OUT_OF_MEMORY
+	static void ResetStat();
 #endif
 
 private:
@@ -59,10 +199,27 @@ private:
 
 	CLS_COPY(MemoryManager)
 
-	static void * MemAlloc(size_t size);
+	static void * AllocateBlock(size_t size, int region, MemPolicy policy, const void * site);
+	static void * AllocateFrom(size_t size, int region, MemPolicy policy);
+	static void * MemAlloc(size_t size, int region, MemPolicy policy);
 	static void MemFree(void * ptr);
+	static void * HeapAlloc(size_t size, int region = -1, MemPolicy policy = MemPolicyDefault);
+	static void HeapFree(void * ptr);
+#if MACS_MEM_TASK_ARENA
+	static void * ArenaAlloc(size_t size);
+#endif
+#if MACS_MEM_SIZE_CLASSES
+	static void * ClassAlloc(size_t size);
+	static void ClassFree(void * ptr);
+#endif
+#if MACS_MEM_TLSF
+	static void InitHeap();
+#endif
 
 	static void LogAllocatedSize();
+#if MACS_MEM_STATISTICS
+	static void CountRequest(size_t size);
+#endif
 
 	static bool s_init_flag;
 	static size_t s_heap_size;
@@ -72,7 +229,10 @@ template <uint32_t heapSize>
 void MemoryManager::Initialize()
 {
 	s_heap_size = heapSize;
-	s_init_flag = true;
+	s_init_flag = true;		// до InitHeap, так как платформа регистрирует в нем свои области
+#if MACS_MEM_TLSF
+	InitHeap();
+#endif
 }
 
 ////////////////////////////////////////////////////////////////
@@ -80,6 +240,9 @@ void MemoryManager::Initialize()
 /// @brief Пулы памяти с фиксированным размером блока.
 /// @details Пулы памяти могут быть использованы в пользовательском приложении для управления
 /// блоками памяти фиксированного размера с предсказуемым временем выполнения.
+/// Список свободных блоков изменяется без паузы планировщика и критических секций (на ядрах M3 и
+/// выше - с помощью LDREX/STREX), поэтому блоки можно выделять и освобождать как в задачах,
+/// так и в обработчиках прерываний.
 class MemoryPool
 {
 private:
@@ -92,9 +255,12 @@ private:
 	bool	m_is_alien_mem;
 	size_t	m_block_size;
 	size_t	m_block_total;
-	size_t	m_block_used;
+	volatile size_t	m_block_used;
+#if MACS_MEM_STATISTICS
+	volatile size_t	m_block_peak;	// наибольшее количество одновременно занятых блоков
+#endif
 	byte *       m_block_mem;
-	MemPoolHdr * m_free_list;
+	MemPoolHdr * volatile m_free_list;
 	 
 public:	
 	/// @brief Конструктор.
@@ -130,6 +296,17 @@ public:
 	/// целевой платформе. Значение по умолчанию: 0 (задан в конструкторе).
 	void Create(size_t block_total, void * mem = nullptr, size_t block_size = 0);
 
+	/// @brief Добавление блоков в пул.
+	/// @details Добавляет в пул блоки, размещенные во внешней памяти. Может применяться только к пулу,
+	/// созданному без собственной памяти (например, конструктором без параметров), и позволяет
+	/// пополнять пул по мере необходимости. Добавленная память пулом не освобождается.
+	/// Одновременный вызов Extend из нескольких задач не допускается, выделение и освобождение
+	/// блоков во время Extend допустимо.
+	/// @param block_total - количество добавляемых блоков.
+	/// @param mem - указатель на внешнюю память размером block_total * GetBlockSize() байт.
+	/// @param block_size - размер блоков памяти в байтах. Значение по умолчанию: 0 (задан ранее).
+	void Extend(size_t block_total, void * mem, size_t block_size = 0);
+
 	/// @brief Выделение блока памяти.
 	/// @details Если имеется доступный для выделения блок памяти (количество свободных блоков > 0),
 	/// функция возвращает указатель на свободный блок. При этом количество доступных блоков
@@ -138,6 +315,7 @@ public:
 	/// При выделении блока памяти проверка готовности пула не производится, поэтому попытка
 	/// выделения блока из неинициализированного пула может привести к неопределённому поведению.
 	/// Для проверки готовности пула должна использоваться функция @ref MemoryPool::IsReady.
+	/// Метод можно вызывать из обработчиков прерываний.
 	/// @return Указатель на свободный блок памяти или nullptr.
 	void * AllocBlock();
 
@@ -146,7 +324,7 @@ public:
 	/// увеличивается на 1. Если включена опция @ref MACS_MEM_WIPE, то при освобождении выполняется
 	/// уничтожение данных в памяти блока. Освобождаемый блок должен быть предварительно выделен
 	/// функцией @ref MemoryPool::AllocBlock. Использование неверного указателя может привести к
-	/// неопределённому поведению.
+	/// неопределённому поведению. Метод можно вызывать из обработчиков прерываний.
 	/// @param pblk - Указатель на начало освобождаемого блока памяти.
 	void FreeBlock(void * pblk);
 
@@ -174,14 +352,111 @@ public:
 	/// @return Количество занятых блоков.
 	inline size_t GetAllocatedBlocksQty() const { return m_block_used; }
 
+#if MACS_MEM_STATISTICS
+	/// @brief Получение наименьшего количества свободных блоков.
+	/// @details Функция возвращает наименьшее количество свободных блоков за время работы пула
+	/// (с учетом блоков, добавленных @ref MemoryPool::Extend), что позволяет оценить запас емкости пула.
+	/// @return Наименьшее количество свободных блоков.
+	inline size_t GetMinFreeBlocksQty() const { return m_block_total - m_block_peak; }
+#endif
+
 private:
 	static inline bool IsGoodSize(size_t block_size) { return (block_size & (HDR_SIZE - 1)) == 0x0; }
 	void Free();
+	MemPoolHdr * Pop();
+	void Push(MemPoolHdr * first, MemPoolHdr * last);
+	static size_t AtomicAdd(volatile size_t & val, size_t delta);
+#if MACS_MEM_STATISTICS
+	void UpdatePeak(size_t used);
+#endif
 	inline MemPoolHdr * Shift(MemPoolHdr * ph, size_t ind = 1) { return (MemPoolHdr *) (((byte *) ph) + (ind * m_block_size)); }
 };
 
 ////////////////////////////////////////////////////////////////
 
+/// @brief Арена (область) памяти с последовательным выделением.
+/// @details Блоки выделяются сдвигом указателя за O(1) и по отдельности не освобождаются: память
+/// возвращается целиком (Reset) или до запомненной отметки (GetMark/Rewind). Арена подходит для
+/// множества короткоживущих объектов (разбор команд, формирование отчетов), освобождение которых
+/// по одному обходилось бы паузой планировщика на каждый блок. Деструкторы объектов, размещенных
+/// в арене, при ее сбросе не вызываются. Арена не выполняет синхронизацию и должна использоваться
+/// одной задачей.
+class Arena
+{
+public:
+	/// @brief Отметка заполнения арены (см. @ref Arena::GetMark)
+	typedef size_t Mark;
+
+	/// @brief Конструктор.
+	/// @details Если указан размер, арена будет автоматически инициализирована (см. @ref Arena::Create).
+	/// @param size - размер арены в байтах.
+	/// @param mem - указатель на внешнюю память для размещения арены.
+	Arena(size_t size = 0, void * mem = nullptr);
+
+	/// @brief Деструктор.
+	/// @details Если арена была размещена в динамической памяти, память освобождается.
+	~Arena() { Free(); }
+
+	/// @brief Инициализация арены.
+	/// @details Если арена уже была инициализирована, ее память освобождается (при размещении в динамической
+	/// памяти), а все ранее выделенные в ней блоки считаются недействительными.
+	/// @param size - размер арены в байтах.
+	/// @param mem - указатель на внешнюю (например, статическую) память. Если не указан, память для арены
+	/// выделяется одним блоком из кучи.
+	void Create(size_t size, void * mem = nullptr);
+
+	/// @brief Получение статуса готовности арены.
+	inline bool IsReady() const { return m_size != 0; }
+
+	/// @brief Выделение блока памяти.
+	/// @details Блок выравнивается на 8 байт.
+	/// @param size - размер в байтах.
+	/// @return Указатель на блок или nullptr, если в арене недостаточно места.
+	void * Alloc(size_t size);
+
+	/// @brief Получить отметку текущего заполнения арены.
+	inline Mark GetMark() const { return m_used; }
+
+	/// @brief Вернуть арену к отметке.
+	/// @details Блоки, выделенные после получения отметки, становятся недействительными.
+	/// @param mark - отметка, полученная @ref Arena::GetMark.
+	void Rewind(Mark mark);
+
+	/// @brief Освободить все блоки арены.
+	inline void Reset() { Rewind(0); }
+
+	/// @brief Получение размера арены в байтах.
+	inline size_t GetSize() const { return m_size; }
+
+	/// @brief Получение объема выделенной памяти в байтах.
+	inline size_t GetUsed() const { return m_used; }
+
+	/// @brief Получение объема свободной памяти в байтах.
+	inline size_t GetFree() const { return m_size - m_used; }
+
+#if MACS_MEM_STATISTICS
+	/// @brief Получение наибольшего объема выделенной памяти в байтах.
+	inline size_t GetPeak() const { return m_peak; }
+#endif
+
+private:
+	CLS_COPY(Arena)
+
+	static const size_t ALIGN = 8;
+
+	void Free();
+
+	byte * m_mem;
+	size_t m_size;
+	size_t m_used;
+#if MACS_MEM_STATISTICS
+	size_t m_peak;
+#endif
+	bool   m_is_alien_mem;
+};
+
+////////////////////////////////////////////////////////////////
+
 class MemoryHeap  // Размеры в словах
 {
 private:	
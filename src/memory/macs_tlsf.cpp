@@ -0,0 +1,204 @@
+/// @file macs_tlsf.cpp
+/// @brief Распределитель памяти TLSF (Two-Level Segregated Fit).
+/// @details Выделение и освобождение блоков за O(1).
+/// @copyright AstroSoft Ltd, 2016
+
+#include "macs_tlsf.hpp"
+
+namespace macs {
+
+void TlsfHeap::Reset()
+{
+	m_ready = false;
+	m_fl_map = 0;
+	m_free_blocks = 0;
+	m_free_size = 0;
+	loop ( uint, fl, FL_COUNT ) {
+		m_sl_map[fl] = 0;
+		loop ( uint, sl, SL_COUNT )
+			m_free[fl][sl] = nullptr;
+	}
+}
+
+void TlsfHeap::Init(void * mem, size_t size)
+{
+	Reset();
+
+	byte * pos = reinterpret_cast<byte *>(((uintptr_t) mem + ALIGN - 1) & ~ (uintptr_t) (ALIGN - 1));
+	byte * end = reinterpret_cast<byte *>(((uintptr_t) mem + size) & ~ (uintptr_t) (ALIGN - 1));
+
+	// каждый участок завершается занятым блоком нулевого размера, на котором останавливается
+	// объединение; область больше BLOCK_MAX разбивается на несколько таких участков
+	while ( end > pos && (size_t) (end - pos) >= 2 * HDR_SIZE + MIN_SIZE ) {
+		size_t len = (end - pos) - 2 * HDR_SIZE;
+		if ( len > BLOCK_MAX )
+			len = BLOCK_MAX;
+
+		Block * b = reinterpret_cast<Block *>(pos);
+		b->m_size = len | BLOCK_FREE;
+		Block * last = Next(b);
+		last->m_prev_phys = b;
+		last->m_size = BLOCK_PREV_FREE;
+		Insert(b);
+
+		pos = static_cast<byte *>(ToPtr(last));
+		m_ready = true;
+	}
+}
+
+void TlsfHeap::MappingInsert(size_t size, uint & fl, uint & sl)
+{
+	if ( size < SMALL_BLOCK ) {
+		fl = 0;
+		sl = size >> ALIGN_LOG2;
+	} else {
+		uint bit = Fls(size);
+		sl = (size >> (bit - SL_LOG2)) ^ SL_COUNT;
+		fl = bit - (FL_SHIFT - 1);
+	}
+}
+
+void TlsfHeap::MappingSearch(size_t size, uint & fl, uint & sl)
+{
+	// размер округляется вверх до границы класса, чтобы любой блок найденного класса был достаточен
+	if ( size >= SMALL_BLOCK )
+		size += (1u << (Fls(size) - SL_LOG2)) - 1;
+	MappingInsert(size, fl, sl);
+}
+
+void TlsfHeap::Insert(Block * b)
+{
+	uint fl, sl;
+	MappingInsert(Size(b), fl, sl);
+
+	Block * head = m_free[fl][sl];
+	b->m_next_free = head;
+	b->m_prev_free = nullptr;
+	if ( head )
+		head->m_prev_free = b;
+	m_free[fl][sl] = b;
+
+	m_fl_map |= 1u << fl;
+	m_sl_map[fl] |= 1u << sl;
+
+	++ m_free_blocks;
+	m_free_size += Size(b);
+}
+
+void TlsfHeap::Remove(Block * b)
+{
+	uint fl, sl;
+	MappingInsert(Size(b), fl, sl);
+
+	if ( b->m_next_free )
+		b->m_next_free->m_prev_free = b->m_prev_free;
+	if ( b->m_prev_free )
+		b->m_prev_free->m_next_free = b->m_next_free;
+	else {
+		m_free[fl][sl] = b->m_next_free;
+		if ( ! b->m_next_free ) {
+			m_sl_map[fl] &= ~ (1u << sl);
+			if ( ! m_sl_map[fl] )
+				m_fl_map &= ~ (1u << fl);
+		}
+	}
+
+	-- m_free_blocks;
+	m_free_size -= Size(b);
+}
+
+TlsfHeap::Block * TlsfHeap::FindSuitable(uint fl, uint sl)
+{
+	uint32_t sl_map = m_sl_map[fl] & (~ 0u << sl);
+	if ( ! sl_map ) {
+		// в этом классе первого уровня блоков нет - берется наименьший непустой из старших
+		const uint32_t fl_map = fl + 1 < 32 ? m_fl_map & (~ 0u << (fl + 1)) : 0;
+		if ( ! fl_map )
+			return nullptr;
+		fl = Ffs(fl_map);
+		sl_map = m_sl_map[fl];
+	}
+	return m_free[fl][Ffs(sl_map)];
+}
+
+size_t TlsfHeap::GetLargestFree() const
+{
+	if ( ! m_fl_map )
+		return 0;
+
+	const uint fl = Fls(m_fl_map);
+	size_t res = 0;
+	for ( const Block * b = m_free[fl][Fls(m_sl_map[fl])]; b; b = b->m_next_free )
+		if ( Size(b) > res )
+			res = Size(b);
+	return res;
+}
+
+void * TlsfHeap::Alloc(size_t size)
+{
+	if ( ! m_ready || ! size || size > BLOCK_MAX )
+		return nullptr;
+
+	size = (size + ALIGN - 1) & ~ (ALIGN - 1);
+	if ( size < MIN_SIZE )
+		size = MIN_SIZE;
+
+	uint fl, sl;
+	MappingSearch(size, fl, sl);
+	if ( fl >= FL_COUNT )
+		return nullptr;
+
+	Block * b = FindSuitable(fl, sl);
+	if ( ! b )
+		return nullptr;
+	Remove(b);
+
+	Block * next = Next(b);
+	const size_t rest = Size(b) - size;
+	if ( rest >= HDR_SIZE + MIN_SIZE ) {
+		// остаток выделяется в отдельный свободный блок; следующий блок по-прежнему имеет свободного соседа
+		b->m_size = size | (b->m_size & BLOCK_PREV_FREE);
+		Block * r = Next(b);
+		r->m_prev_phys = b;
+		r->m_size = (rest - HDR_SIZE) | BLOCK_FREE;
+		next->m_prev_phys = r;
+		Insert(r);
+	} else {
+		b->m_size &= ~ BLOCK_FREE;
+		next->m_size &= ~ BLOCK_PREV_FREE;
+	}
+
+	return ToPtr(b);
+}
+
+void TlsfHeap::Free(void * ptr)
+{
+	if ( ! ptr )
+		return;
+
+	Block * b = ToBlock(ptr);
+	_ASSERT(! IsFree(b));
+
+	size_t size = Size(b);
+	if ( IsPrevFree(b) ) {
+		Block * prev = b->m_prev_phys;
+		Remove(prev);
+		size += Size(prev) + HDR_SIZE;
+		b = prev;
+	}
+
+	Block * next = reinterpret_cast<Block *>(static_cast<byte *>(ToPtr(b)) + size);
+	if ( IsFree(next) ) {
+		Remove(next);
+		size += Size(next) + HDR_SIZE;
+		next = reinterpret_cast<Block *>(static_cast<byte *>(ToPtr(b)) + size);
+	}
+
+	// предшествующий блок занят: иначе он был бы объединен при его освобождении
+	b->m_size = size | BLOCK_FREE;
+	next->m_prev_phys = b;
+	next->m_size |= BLOCK_PREV_FREE;
+	Insert(b);
+}
+
+}	// namespace macs
@@ -0,0 +1,127 @@
+/// @file macs_tlsf.hpp
+/// @brief Распределитель памяти TLSF (Two-Level Segregated Fit).
+/// @details Свободные блоки хранятся в списках, разбитых на классы размеров по двум уровням:
+/// первый уровень - степень двойки размера, второй - равные доли внутри степени. Наличие
+/// свободных блоков в классах отмечается битовыми картами, поэтому поиск подходящего блока,
+/// его разделение и объединение соседних свободных блоков выполняются за O(1) и не зависят
+/// от количества блоков в куче.
+/// @copyright AstroSoft Ltd, 2016
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "macs_system.hpp"
+
+namespace macs {
+
+/// @brief Куча с распределителем TLSF.
+/// @details Методы не выполняют синхронизацию, она обеспечивается вызывающей стороной (MemoryManager).
+class TlsfHeap
+{
+public:
+	// Конструктор не изменяет полей: статическая куча может быть инициализирована (Init)
+	// до вызова конструкторов статических объектов, а до этого ее поля обнулены.
+	TlsfHeap() {}
+
+	/// @brief Инициализация кучи областью памяти
+	/// @details Ранее выделенные блоки считаются недействительными.
+	/// @param mem - начало области
+	/// @param size - размер области в байтах
+	void Init(void * mem, size_t size);
+
+	inline bool IsReady() const { return m_ready; }
+
+	/// @brief Выделение блока памяти
+	/// @param size - размер в байтах
+	/// @return Указатель на блок (выровнен на 8 байт) или nullptr
+	void * Alloc(size_t size);
+
+	/// @brief Освобождение блока памяти, выделенного Alloc
+	void Free(void * ptr);
+
+	/// @brief Количество свободных блоков
+	inline size_t GetFreeBlocks() const { return m_free_blocks; }
+
+	/// @brief Объем свободной памяти в байтах (без заголовков)
+	inline size_t GetFreeSize() const { return m_free_size; }
+
+	/// @brief Размер наибольшего свободного блока
+	/// @details Просматривается только список старшего непустого класса.
+	size_t GetLargestFree() const;
+
+	/// @brief Полезный размер выделенного блока (не меньше запрошенного)
+	static inline size_t BlockSize(const void * ptr) { return Size(ToBlock(const_cast<void *>(ptr))); }
+
+	/// @brief Накладные расходы на один блок в байтах
+	static inline size_t Overhead() { return HDR_SIZE; }
+
+	/// @brief Признак блока, выделенного не кучей
+	/// @details В выделенном блоке кучи этот бит слова, предшествующего данным (размера блока), всегда
+	/// сброшен. Распределители поверх кучи могут устанавливать его в своих заголовках того же размера
+	/// (Overhead), чтобы при освобождении отличать свои блоки (IsForeign).
+	static const size_t FOREIGN_TAG = 4u;
+
+	/// @brief Проверка, что блок помечен FOREIGN_TAG
+	static inline bool IsForeign(const void * ptr) { return (ToBlock(const_cast<void *>(ptr))->m_size & FOREIGN_TAG) != 0; }
+
+private:
+	CLS_COPY(TlsfHeap)
+
+	static const uint ALIGN_LOG2 = 3;                              // выравнивание блоков - 8 байт
+	static const size_t ALIGN = 1u << ALIGN_LOG2;
+	static const uint SL_LOG2 = 3;                                 // 8 классов внутри степени двойки
+	static const uint SL_COUNT = 1u << SL_LOG2;
+	static const uint FL_SHIFT = SL_LOG2 + ALIGN_LOG2;             // блоки меньше 64 байт - в классе 0
+	static const uint FL_MAX = 18;                                 // наибольший блок - менее 512 Кбайт (область может быть больше)
+	static const uint FL_COUNT = FL_MAX - FL_SHIFT + 2;
+	static const size_t SMALL_BLOCK = 1u << FL_SHIFT;
+	static const size_t BLOCK_MAX = (1u << (FL_MAX + 1)) - ALIGN;
+
+	// Заголовок блока. Поля m_next_free и m_prev_free существуют только в свободном блоке
+	// и занимают начало его данных.
+	struct Block
+	{
+		Block * m_prev_phys;   // предыдущий блок в памяти (действителен, если он свободен)
+		size_t  m_size;        // размер данных блока и флаги BLOCK_FREE, BLOCK_PREV_FREE
+		Block * m_next_free;
+		Block * m_prev_free;
+	};
+	static const size_t HDR_SIZE = offsetof(Block, m_next_free);
+	static const size_t MIN_SIZE = sizeof(Block) - HDR_SIZE;
+
+	static const size_t BLOCK_FREE      = 1u;
+	static const size_t BLOCK_PREV_FREE = 2u;
+	static const size_t FLAGS_MASK      = ALIGN - 1;
+
+	static inline size_t Size(const Block * b) { return b->m_size & ~ FLAGS_MASK; }
+	static inline bool IsFree(const Block * b) { return (b->m_size & BLOCK_FREE) != 0; }
+	static inline bool IsPrevFree(const Block * b) { return (b->m_size & BLOCK_PREV_FREE) != 0; }
+	static inline void * ToPtr(Block * b) { return reinterpret_cast<byte *>(b) + HDR_SIZE; }
+	static inline Block * ToBlock(void * ptr) { return reinterpret_cast<Block *>(static_cast<byte *>(ptr) - HDR_SIZE); }
+	static inline Block * Next(Block * b) { return reinterpret_cast<Block *>(static_cast<byte *>(ToPtr(b)) + Size(b)); }
+
+	// Номер старшего и младшего установленного бита
+	static inline uint Fls(uint32_t val) { return 31 - MACS_CLZ(val); }
+	static inline uint Ffs(uint32_t val) { return Fls(val & (0 - val)); }
+
+	// Класс, в котором хранится блок размера size
+	static void MappingInsert(size_t size, uint & fl, uint & sl);
+	// Класс, любой блок которого не меньше size
+	static void MappingSearch(size_t size, uint & fl, uint & sl);
+
+	void Reset();
+	void Insert(Block * b);
+	void Remove(Block * b);
+	Block * FindSuitable(uint fl, uint sl);
+
+	bool     m_ready;
+	uint32_t m_fl_map;                       // непустые классы первого уровня
+	uint32_t m_sl_map[FL_COUNT];             // непустые классы второго уровня
+	Block *  m_free[FL_COUNT][SL_COUNT];     // списки свободных блоков
+	size_t   m_free_blocks;
+	size_t   m_free_size;
+};
+
+}	// namespace macs
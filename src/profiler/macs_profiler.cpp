@@ -14,6 +14,12 @@
 #include "macs_task.hpp"
 #include "macs_profiler.hpp"
  
+namespace macs {
+
+volatile uint32_t CriticalSection::s_max_masked = 0;
+
+}	// namespace macs
+
 namespace performance {
 	
 ProfData g_prof_data[PE_QTTY];
@@ -125,6 +131,7 @@ static CSPTR EyeName(PROF_EYE eye)
 	case PE_TASK_DEL :	return "TaskDel";
 	
 	case PE_IQR_HANDLE : return "IrqHandle"; 
+	case PE_SYS_TICK : return "SysTick"; 
 
 	case PE_EVENT_INIT : 		return "EventInit"; 
 	case PE_EVENT_RAISE : 	return "EventRaise"; 
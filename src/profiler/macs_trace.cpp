@@ -0,0 +1,93 @@
+/// @file macs_trace.cpp
+/// @brief Трассировка ядра.
+/// @details Кольцевой буфер двоичных записей о событиях ядра.
+/// @copyright AstroSoft Ltd, 2016
+
+#include "macs_trace.hpp"
+
+#if MACS_USE_TRACE
+
+#include "macs_common.hpp"
+#include "macs_scheduler.hpp"
+
+namespace macs {
+
+#if MACS_TRACE_SIZE & (MACS_TRACE_SIZE - 1)
+	#error MACS_TRACE_SIZE must be a power of 2
+#endif
+
+// Быстрый путь мьютекса и семафора выполняется в режиме задачи, в том числе непривилегированной, которой
+// недоступны DWT и буфер трассировки, поэтому с трассировкой операции синхронизации всегда идут через ядро
+#if MACS_SYNC_FAST_PATH
+	#error MACS_USE_TRACE requires MACS_SYNC_FAST_PATH 0: fast-path Wait/Signal/Lock/Unlock are not traced
+#endif
+
+TraceRecord Trace::s_ring[MACS_TRACE_SIZE];
+volatile uint32_t Trace::s_pos = 0;
+volatile bool Trace::s_enabled = true;
+
+// Резервирует место для записи и получает ее метку времени. На ядрах M3 и выше - без критической секции, 
+// поэтому запись может вызываться из прерываний любого приоритета. Метка читается между LDREX и STREX:
+// прерывание, записавшее событие в этом промежутке, сбрасывает монитор, и попытка повторяется с новой
+// меткой, поэтому метки в буфере идут в порядке записей.
+uint32_t Trace::Reserve(uint32_t & stamp)
+{
+#if MACS_MCU_CORE >= MACS_CORTEX_M3
+	uint32_t pos;
+	do {
+		pos = MACS_LDREXW((uint32_t *) & s_pos);
+		stamp = System::GetCurCpuTick();
+	} while ( MACS_STREXW(pos + 1, (uint32_t *) & s_pos) );
+	return pos;
+#else
+	const uint32_t mask = System::DisableIrq();
+	const uint32_t pos = s_pos ++;
+	stamp = Sch().GetTickCount();
+	System::EnableIrq(mask);
+	return pos;
+#endif
+}
+
+void Trace::Put(Kind kind, uint16_t id, uint8_t arg)
+{
+	if ( ! s_enabled )
+		return;
+
+	uint32_t stamp;
+	TraceRecord & rec = s_ring[Reserve(stamp) & (MACS_TRACE_SIZE - 1)];
+	rec.m_stamp = stamp;
+	rec.m_kind = static_cast<uint8_t>(kind);
+	rec.m_arg = arg;
+	rec.m_id = id;
+}
+
+void Trace::Clear()
+{
+	s_pos = 0;
+}
+
+uint32_t Trace::Read(TraceRecord * dst, uint32_t max_qty)
+{
+	const uint32_t pos = s_pos;
+	uint32_t qty = pos < MACS_TRACE_SIZE ? pos : MACS_TRACE_SIZE;
+	if ( qty > max_qty )
+		qty = max_qty;
+
+	for ( uint32_t i = pos - qty; i != pos; ++ i )
+		* dst ++ = s_ring[i & (MACS_TRACE_SIZE - 1)];
+
+	return qty;
+}
+
+uint32_t Trace::GetStampFreq()
+{
+#if MACS_MCU_CORE >= MACS_CORTEX_M3
+	return System::GetCpuFreq();
+#else
+	return System::GetTickRate();
+#endif
+}
+
+}	// namespace macs
+
+#endif
@@ -6,6 +6,7 @@
 
 #include "macs_event.hpp"
 #include "macs_critical_section.hpp"
+#include "macs_trace.hpp"
 
 namespace macs {
 
@@ -24,6 +25,11 @@ Result Event::Raise()
 	if ( ! System::IsSysCallAllowed() )
 		return ResultErrorSysCallNotAllowed;
 
+#if MACS_IRQ_POST
+	if ( System::IsInInterrupt() && ! System::IsInSysCall() )
+		return Sch().PostFromIrq(this, NULL, NULL, EPM_Event_Raise_Priv);
+#endif
+
 	return System::IsInPrivOrIrq() ? Raise_Priv(this) 
 	                               : SvcExecPrivileged(this, NULL, NULL, EPM_Event_Raise_Priv);
 }
@@ -31,6 +37,13 @@ Result Event::Raise()
 Result Event::Raise_Priv(Event * event)
 {
 	CriticalSection _cs_;
+	MACS_TRACE(EventRaise, Trace::Id(event), 0);
+
+#if MACS_WAIT_MULTIPLE
+	// одиночное событие получает задача, ожидающая через WaitMultiple, только если нет ожидающих через Wait
+	if ( event->m_broadcast || ! event->IsHolding() )
+		event->NotifySelect(false, event->m_broadcast);
+#endif
 
 	while ( event->IsHolding() )	{
 		event->UnblockTask();
@@ -62,6 +75,7 @@ Result Event::Wait(uint32_t timeout_ms)
 Result Event::Wait_Priv(Event * event, uint32_t timeout_ms)
 {
 	CriticalSection _cs_;
+	MACS_TRACE(EventWait, Trace::Id(event), 0);
 
 	if ( timeout_ms == 0 )
 		return ResultTimeout;
@@ -0,0 +1,151 @@
+/// @file macs_event_group.cpp
+/// @brief Группы событий.
+/// @details Группа событий хранит 32 флага, которые могут устанавливаться и сбрасываться задачами
+/// и обработчиками прерываний. Задача может ожидать установки любого или всех флагов из указанной маски.
+/// @copyright AstroSoft Ltd, 2016
+
+#include "macs_event_group.hpp"
+#include "macs_critical_section.hpp"
+#include "macs_trace.hpp"
+
+#if MACS_EVENT_GROUPS
+
+namespace macs {
+
+EventGroup::EventGroup(uint32_t flags) :
+	m_flags(flags)
+{}
+
+EventGroup::~EventGroup()
+{}
+
+Result EventGroup::Set(uint32_t flags)
+{
+	if ( ! Sch().IsInitialized() || ! Sch().IsStarted() )
+		return ResultErrorInvalidState;
+
+	if ( ! System::IsSysCallAllowed() )
+		return ResultErrorSysCallNotAllowed;
+
+#if MACS_IRQ_POST
+	if ( System::IsInInterrupt() && ! System::IsInSysCall() )
+		return Sch().PostFromIrq(this, reinterpret_cast<void*>(flags), NULL, EPM_EventGroup_Set_Priv);
+#endif
+
+	return System::IsInPrivOrIrq() ? Set_Priv(this, flags)
+	                               : SvcExecPrivileged(this, reinterpret_cast<void*>(flags), NULL, EPM_EventGroup_Set_Priv);
+}
+
+Result EventGroup::Set_Priv(EventGroup * group, uint32_t flags)
+{
+	CriticalSection _cs_;
+	MACS_TRACE(EventGroupSet, Trace::Id(group), 0);
+
+	const uint32_t cur = group->m_flags | flags;
+	uint32_t clear = 0;
+
+	// задачи разблокируются в пределах одной критической секции, поэтому переключение
+	// контекста (на самую приоритетную из них) выполняется однократно после ее завершения
+	Task ** link = & group->m_blocked_task_list;
+	while ( * link ) {
+		Task * task = * link;
+		if ( ! IsSatisfied(cur, task->m_flags_wait, task->m_flags_options) ) {
+			link = & task->m_next_sync_task;
+			continue;
+		}
+
+		* link = task->m_next_sync_task;
+		task->m_next_sync_task = nullptr;
+		task->DropBlockSync(group);
+		task->m_flags_recv = cur;
+		if ( task->m_flags_options & WaitAutoClear )
+			clear |= task->m_flags_wait;
+		Sch().UnblockTask(task);
+	}
+
+	// флаги сбрасываются после проверки всех задач, чтобы каждая из них видела полное значение
+	group->m_flags = cur & ~ clear;
+#if MACS_WAIT_MULTIPLE
+	group->NotifySelect(true, true);
+#endif
+	return ResultOk;
+}
+
+Result EventGroup::Clear(uint32_t flags)
+{
+	if ( ! Sch().IsInitialized() )
+		return ResultErrorInvalidState;
+
+	if ( ! System::IsSysCallAllowed() )
+		return ResultErrorSysCallNotAllowed;
+
+#if MACS_IRQ_POST
+	if ( Sch().IsStarted() && System::IsInInterrupt() && ! System::IsInSysCall() )
+		return Sch().PostFromIrq(this, reinterpret_cast<void*>(flags), NULL, EPM_EventGroup_Clear_Priv);
+#endif
+
+	return System::IsInPrivOrIrq() ? Clear_Priv(this, flags)
+	                               : SvcExecPrivileged(this, reinterpret_cast<void*>(flags), NULL, EPM_EventGroup_Clear_Priv);
+}
+
+Result EventGroup::Clear_Priv(EventGroup * group, uint32_t flags)
+{
+	CriticalSection _cs_;
+	group->m_flags &= ~ flags;
+	return ResultOk;
+}
+
+Result EventGroup::Wait(uint32_t mask, uint32_t & flags, uint32_t options, uint32_t timeout_ms)
+{
+	if ( ! Sch().IsInitialized() || ! Sch().IsStarted() )
+		return ResultErrorInvalidState;
+
+	if ( System::IsInInterrupt() )
+		return ResultErrorInterruptNotSupported;
+
+	if ( ! mask )
+		return ResultErrorInvalidArgs;
+
+	WaitArgs args;
+	args.m_mask = mask;
+	args.m_options = options;
+
+	Task * cur_task = Task::GetCurrent();
+	Result res = System::IsInPrivOrIrq() ? Wait_Priv(this, & args, timeout_ms)
+	                                     : SvcExecPrivileged(this, & args, reinterpret_cast<void*>(timeout_ms), EPM_EventGroup_Wait_Priv);
+	if ( res == ResultTimeout || (res == ResultOk && cur_task->m_unblock_reason == Task::UnblockReasonTimeout) ) {
+		flags = m_flags;
+		return ResultTimeout;
+	}
+	if ( res != ResultOk )
+		return res;
+
+	flags = cur_task->m_flags_recv;
+	return ResultOk;
+}
+
+Result EventGroup::Wait_Priv(EventGroup * group, const WaitArgs * args, uint32_t timeout_ms)
+{
+	CriticalSection _cs_;
+	MACS_TRACE(EventGroupWait, Trace::Id(group), 0);
+
+	Task * task = Sch().GetCurrentTask();
+	if ( IsSatisfied(group->m_flags, args->m_mask, args->m_options) ) {
+		task->m_flags_recv = group->m_flags;
+		if ( args->m_options & WaitAutoClear )
+			group->m_flags &= ~ args->m_mask;
+		task->m_unblock_reason = Task::UnblockReasonNone;	// по этому полю выше судят о результате операции
+		return ResultOk;
+	}
+
+	if ( timeout_ms == 0 )
+		return ResultTimeout;
+
+	task->m_flags_wait = args->m_mask;
+	task->m_flags_options = static_cast<uint8_t>(args->m_options);
+	return group->BlockCurTask(timeout_ms);
+}
+
+}	// namespace macs
+
+#endif
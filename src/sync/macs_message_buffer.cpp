@@ -0,0 +1,250 @@
+/// @file macs_message_buffer.cpp
+/// @brief Буфер сообщений переменной длины.
+/// @details Записи с префиксом длины хранятся подряд в одном кольцевом буфере.
+/// @copyright AstroSoft Ltd, 2016
+
+#include <string.h>
+
+#include "macs_message_buffer.hpp"
+
+namespace macs {
+
+MessageBuffer::MessageBuffer(size_t size, byte * mem) :
+	m_size(size & ~ (HDR_SIZE - 1)),	// записи выравниваются на 4 байта
+	m_head(0),
+	m_tail(0),
+	m_used(0),
+	m_count(0),
+	m_trigger(1),
+	m_acquirer(nullptr),
+	m_recv_waiters(0),
+	m_send_waiters(0),
+	m_recv_gen(0),
+	m_send_gen(0),
+	m_data_sem(0, ~ (size_t) 0),	// счетчики семафоров - разрешения на повторную попытку, по одному на ожидающую задачу
+	m_space_sem(0, ~ (size_t) 0)
+{
+	if ( ! mem ) {
+		m_mem = reinterpret_cast<byte *>(new uint32_t[m_size / HDR_SIZE]);
+		m_is_alien_mem = false;
+	} else {
+		m_mem = mem;
+		m_is_alien_mem = true;
+	}
+}
+
+MessageBuffer::~MessageBuffer()
+{
+	if ( ! m_is_alien_mem )
+		delete [] reinterpret_cast<uint32_t *>(m_mem);
+}
+
+size_t MessageBuffer::Place(size_t span, size_t & pad)
+{
+	pad = 0;
+	if ( span > m_size - m_used )
+		return m_size;
+
+	if ( ! m_used )	// пустой буфер заполняется с начала, чтобы поместилась запись максимальной длины
+		m_head = m_tail = 0;
+
+	if ( m_tail >= m_head ) {	// свободны конец и начало буфера
+		if ( span <= m_size - m_tail )
+			return m_tail;
+		if ( span <= m_head ) {
+			pad = m_size - m_tail;
+			return 0;
+		}
+		return m_size;
+	}
+
+	return span <= m_head - m_tail ? m_tail : m_size;
+}
+
+Result MessageBuffer::Send(const void * data, size_t len, uint32_t timeout_ms)
+{
+	if ( ! Sch().IsInitialized() || ! Sch().IsStarted() )
+		return ResultErrorInvalidState;
+
+	if ( System::IsInInterrupt() )
+		return ResultErrorInterruptNotSupported;
+
+	if ( len > GetMaxMessageSize() || (len && ! data) )
+		return ResultErrorInvalidArgs;
+
+	const size_t span = Span(len);
+	for(;;) {
+		uint32_t gen;
+		{
+			PauseSection _ps_;
+			size_t pad;
+			const size_t pos = Place(span, pad);
+			if ( pos != m_size ) {
+				if ( pad )
+					* reinterpret_cast<uint32_t *>(m_mem + m_tail) = WRAP_MARK;
+				* reinterpret_cast<uint32_t *>(m_mem + pos) = len;
+				memcpy(m_mem + pos + HDR_SIZE, data, len);
+
+				m_tail = pos + span;
+				if ( m_tail == m_size )
+					m_tail = 0;
+				m_used += pad + span;
+				++ m_count;
+
+				if ( m_used >= m_trigger )
+					WakeAll(m_data_sem, m_recv_waiters, m_recv_gen);
+				return ResultOk;
+			}
+			if ( ! timeout_ms )
+				return ResultTimeout;
+			gen = m_send_gen;
+			++ m_send_waiters;
+		}
+
+		// место освобождается получателем, после чего попытка повторяется
+		const Result res = m_space_sem.Wait(timeout_ms);
+		{
+			PauseSection _ps_;
+			LeaveWait(m_send_waiters, m_send_gen, gen);
+		}
+		if ( res != ResultOk )
+			return res;
+	}
+}
+
+Result MessageBuffer::Acquire(const byte * & data, size_t & len, uint32_t timeout_ms)
+{
+	if ( ! Sch().IsInitialized() || ! Sch().IsStarted() )
+		return ResultErrorInvalidState;
+
+	if ( System::IsInInterrupt() )
+		return ResultErrorInterruptNotSupported;
+
+	for(;;) {
+		uint32_t gen;
+		{
+			PauseSection _ps_;
+			if ( m_acquirer == Task::GetCurrent() )
+				return ResultErrorInvalidState;
+			if ( ! m_acquirer && m_count && (m_used >= m_trigger || ! timeout_ms) ) {
+				TakeHead(data, len);
+				return ResultOk;
+			}
+			if ( ! timeout_ms )
+				return ResultTimeout;
+			gen = m_recv_gen;
+			++ m_recv_waiters;
+		}
+
+		const Result res = m_data_sem.Wait(timeout_ms);
+		{
+			PauseSection _ps_;
+			LeaveWait(m_recv_waiters, m_recv_gen, gen);
+			if ( res != ResultOk ) {
+				// по истечении таймаута уровень срабатывания не учитывается
+				if ( res == ResultTimeout && m_count && ! m_acquirer ) {
+					TakeHead(data, len);
+					return ResultOk;
+				}
+				return res;
+			}
+		}
+	}
+}
+
+void MessageBuffer::TakeHead(const byte * & data, size_t & len)
+{
+	if ( * reinterpret_cast<const uint32_t *>(m_mem + m_head) == WRAP_MARK ) {
+		m_used -= m_size - m_head;
+		m_head = 0;
+	}
+	len = * reinterpret_cast<const uint32_t *>(m_mem + m_head);
+	data = m_mem + m_head + HDR_SIZE;
+	m_acquirer = Task::GetCurrent();
+}
+
+Result MessageBuffer::Release()
+{
+	PauseSection _ps_;
+	if ( ! m_acquirer )
+		return ResultErrorInvalidState;
+
+	m_acquirer = nullptr;
+	Drop();
+	// следующее сообщение достается одному из получателей, ожидавших освобождения записи
+	if ( m_count && m_used >= m_trigger )
+		WakeAll(m_data_sem, m_recv_waiters, m_recv_gen);
+	return ResultOk;
+}
+
+void MessageBuffer::Unacquire()
+{
+	PauseSection _ps_;
+	m_acquirer = nullptr;
+	WakeAll(m_data_sem, m_recv_waiters, m_recv_gen);
+}
+
+void MessageBuffer::Drop()
+{
+	const size_t span = Span(* reinterpret_cast<const uint32_t *>(m_mem + m_head));
+	m_head += span;
+	if ( m_head == m_size )
+		m_head = 0;
+	m_used -= span;
+	-- m_count;
+
+	WakeAll(m_space_sem, m_send_waiters, m_send_gen);
+}
+
+void MessageBuffer::WakeAll(Semaphore & sem, size_t & waiters, uint32_t & gen)
+{
+	// каждая задача получает разрешение на повторную попытку: освободившегося места (поступивших данных)
+	// может хватить не первой из них, а сигнал одной задаче при нескольких ожидающих терялся бы
+	if ( ! waiters )
+		return;
+	sem.SignalN(waiters);
+	waiters = 0;
+	++ gen;
+}
+
+void MessageBuffer::LeaveWait(size_t & waiters, uint32_t cur_gen, uint32_t gen)
+{
+	// после разблокировки счетчик уже сброшен; если же задача вышла по таймауту одновременно с разблокировкой,
+	// ее разрешение остается в семафоре и дает лишнюю повторную попытку другой задаче
+	if ( gen == cur_gen )
+		-- waiters;
+}
+
+Result MessageBuffer::Receive(void * data, size_t max_len, size_t & len, uint32_t timeout_ms)
+{
+	const byte * msg;
+	Result res = Acquire(msg, len, timeout_ms);
+	if ( res != ResultOk )
+		return res;
+
+	// выданную запись отправители не изменяют, поэтому копирование выполняется без паузы
+	if ( len > max_len ) {
+		Unacquire();
+		return ResultErrorInvalidArgs;
+	}
+	memcpy(data, msg, len);
+	return Release();
+}
+
+Result MessageBuffer::Receive(Buf & buf, uint32_t timeout_ms)
+{
+	const byte * msg;
+	size_t len;
+	Result res = Acquire(msg, len, timeout_ms);
+	if ( res != ResultOk )
+		return res;
+
+	if ( len > buf.Size() && ! buf.IsDynamic() ) {
+		Unacquire();
+		return ResultErrorInvalidArgs;
+	}
+	buf.Copy(msg, len);
+	return Release();
+}
+
+}	// namespace macs
@@ -12,6 +12,7 @@
 #include "macs_mutex.hpp"
 #include "macs_critical_section.hpp"
 #include "macs_application.hpp"
+#include "macs_trace.hpp"
 
 namespace macs {
 	
@@ -32,6 +33,11 @@ Result Mutex::Lock(uint32_t timeout_ms)
 	if ( System::IsInInterrupt() ) 
 		return ResultErrorInterruptNotSupported;
 
+#if MACS_SYNC_FAST_PATH
+	if ( TryLockFast() )
+		return ResultOk;
+#endif
+
 	Result res = System::IsInPrivOrIrq() ? Lock_Priv(this, timeout_ms) 
 	                                     : SvcExecPrivileged(this, reinterpret_cast<void*>(timeout_ms), NULL, EPM_Mutex_Lock_Priv);
 	if ( res != ResultOk )
@@ -43,6 +49,7 @@ Result Mutex::Lock(uint32_t timeout_ms)
 Result Mutex::Lock_Priv(Mutex * mutex, uint32_t timeout_ms)
 {
 	CriticalSection _cs_;
+	MACS_TRACE(MutexLock, Trace::Id(mutex), 0);
 
 	Task * cur_task = Task::GetCurrent();
 	if ( mutex->m_owner == cur_task ) {	// мьютекс уже был заблокирован нами
@@ -66,17 +73,7 @@ Result Mutex::Lock_Priv(Mutex * mutex, uint32_t timeout_ms)
 	}
 	// либо мьютекс не занят, либо занят другой задачей
 	if ( mutex->m_owner == nullptr ) {	// мьютекс свободен
-		mutex->m_owner = cur_task;
-#if MACS_MUTEX_PRIORITY_INVERSION
-		mutex->m_owner_original_priority = cur_task->m_owned_obj_list ? 
-		                                  cur_task->m_owned_obj_list->m_owner_original_priority :
-		                                  cur_task->GetPriority();
-#endif
-		cur_task->AddOwnedSync(mutex);
-			
-		_ASSERT(mutex->m_lock_cnt == 0);
-		mutex->m_lock_cnt = 1;
-		
+		mutex->SetOwner(cur_task);
 		cur_task->m_unblock_reason = Task::UnblockReasonNone;	// очистим это поле, по нему выше судят о результате операции
 
 		return ResultOk;
@@ -93,6 +90,11 @@ Result Mutex::Unlock()
 	if ( System::IsInInterrupt() ) 
 		return ResultErrorInterruptNotSupported;
 
+#if MACS_SYNC_FAST_PATH
+	if ( TryUnlockFast() )
+		return ResultOk;
+#endif
+
 	return System::IsInPrivOrIrq() ? Unlock_Priv(this) 
 	                               : SvcExecPrivileged(this, NULL, NULL, EPM_Mutex_Unlock_Priv);
 }
@@ -100,6 +102,7 @@ Result Mutex::Unlock()
 Result Mutex::Unlock_Priv(Mutex * mutex)
 {
 	CriticalSection _cs_;
+	MACS_TRACE(MutexUnlock, Trace::Id(mutex), 0);
 
 	Task * cur_task = Sch().GetCurrentTask();
 	if ( ! cur_task || mutex->m_owner != cur_task ) 
@@ -120,9 +123,100 @@ Result Mutex::Unlock_Priv(Mutex * mutex)
 	if ( mutex->IsHolding() )
 		return mutex->UnblockTask();
 	mutex->m_owner = nullptr;
+#if MACS_WAIT_MULTIPLE
+	mutex->NotifySelect(true, false);
+#endif
 	return ResultOk;
 }
 
+void Mutex::SetOwner(Task * task)
+{
+	m_owner = task;
+#if MACS_MUTEX_PRIORITY_INVERSION
+	m_owner_original_priority = task->m_owned_obj_list ? 
+	                            task->m_owned_obj_list->m_owner_original_priority :
+	                            task->GetPriority();
+#endif
+	task->AddOwnedSync(this);
+		
+	_ASSERT(m_lock_cnt == 0);
+	m_lock_cnt = 1;
+}
+
+#if MACS_WAIT_MULTIPLE
+bool Mutex::TryTake(Task * task)
+{
+	if ( ! m_owner ) {
+		SetOwner(task);
+		return true;
+	}
+	if ( m_owner == task && m_recursive && m_lock_cnt < BYTE_MAX ) {
+		++ m_lock_cnt;
+		return true;
+	}
+	return false;
+}
+#endif
+
+#if MACS_SYNC_FAST_PATH
+// Быстрые варианты захвата и освобождения выполняются без перехода в привилегированный режим.
+// Мьютексы используются только задачами (не прерываниями), поэтому для согласованного изменения 
+// владельца, счетчика и списка принадлежащих задаче объектов достаточно паузы планировщика.
+// Всё, что требует блокировки, разблокировки или смены приоритета задачи, выполняется ядром.
+bool Mutex::TryLockFast()
+{
+	if ( ! Sch().IsStarted() )
+		return false;
+
+	Task * cur_task = Task::GetCurrent();
+	PauseSection _ps_;
+	
+	if ( m_owner == cur_task ) {
+		if ( ! m_recursive || m_lock_cnt == BYTE_MAX )	// ошибки обрабатывает ядро
+			return false;
+		++ m_lock_cnt;
+	} else if ( ! m_owner ) {
+		SetOwner(cur_task);
+	} else {
+		return false;
+	}
+
+	cur_task->m_unblock_reason = Task::UnblockReasonNone;
+	return true;
+}
+
+bool Mutex::TryUnlockFast()
+{
+	if ( ! Sch().IsStarted() )
+		return false;
+
+	Task * cur_task = Task::GetCurrent();
+	PauseSection _ps_;
+
+	if ( m_owner != cur_task || IsHolding() )
+		return false;
+#if MACS_WAIT_MULTIPLE
+	if ( IsSelected() )
+		return false;
+#endif
+	
+	_ASSERT(m_lock_cnt > 0);
+	if ( m_lock_cnt > 1 ) {
+		-- m_lock_cnt;
+		return true;
+	}
+
+#if MACS_MUTEX_PRIORITY_INVERSION
+	if ( InheritedPriority() != cur_task->GetPriority() )	// восстановление приоритета выполняет ядро
+		return false;
+#endif
+	cur_task->RemoveOwnedSync(this);
+	m_lock_cnt = 0;
+	m_owner = nullptr;
+	return true;
+}
+#endif
+
 #if	MACS_MUTEX_PRIORITY_INVERSION
 
 extern Result IntSetTaskPriority_Priv(Scheduler * scheduler, Task * task, Task::Priority priority, bool internal_usage);
@@ -155,6 +249,9 @@ Result Mutex::UnlockInternal()
 		return UnblockTask(); 
 
 	m_owner = nullptr;
+#if MACS_WAIT_MULTIPLE
+	NotifySelect(true, false);
+#endif
 
 	return ResultOk;
 }
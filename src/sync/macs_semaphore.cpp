@@ -12,6 +12,7 @@
 
 #include "macs_critical_section.hpp"
 #include "macs_semaphore.hpp"
+#include "macs_trace.hpp"
  
 namespace macs { 
 	
@@ -36,6 +37,13 @@ Result Semaphore::Wait(uint32_t timeout_ms)
 			return ResultErrorInterruptNotSupported;
 	}
 	
+#if MACS_SYNC_FAST_PATH
+	if ( TryDecrementExcl() ) {
+		Task::GetCurrent()->m_unblock_reason = Task::UnblockReasonNone;
+		return ResultOk;
+	}
+#endif
+
 	Result res = System::IsInPrivOrIrq() ? Wait_Priv(this, timeout_ms) 
 	                                     : SvcExecPrivileged(this, reinterpret_cast<void*>(timeout_ms), NULL, EPM_Semaphore_Wait_Priv);	
 	if ( res != ResultOk )
@@ -47,6 +55,7 @@ Result Semaphore::Wait(uint32_t timeout_ms)
 Result Semaphore::Wait_Priv(Semaphore * semaphore, uint32_t timeout_ms)
 {
 	CriticalSection _cs_;
+	MACS_TRACE(SemaphoreWait, Trace::Id(semaphore), 0);
 
 	Task * currentTask = Task::GetCurrent();
 	if ( semaphore->TryDecrement() )	{
@@ -68,6 +77,16 @@ Result Semaphore::Signal()
 	if ( ! System::IsSysCallAllowed() )	
 		return ResultErrorSysCallNotAllowed;
 	
+#if MACS_SYNC_FAST_PATH
+	if ( TryIncrementExcl() )
+		return ResultOk;
+#endif
+
+#if MACS_IRQ_POST
+	if ( System::IsInInterrupt() && ! System::IsInSysCall() )
+		return Sch().PostFromIrq(this, NULL, NULL, EPM_Semaphore_Signal_Priv);
+#endif
+
 	return System::IsInPrivOrIrq() ? Signal_Priv(this) 
 	                               : SvcExecPrivileged(this, NULL, NULL, EPM_Semaphore_Signal_Priv);
 }
@@ -75,6 +94,7 @@ Result Semaphore::Signal()
 Result Semaphore::Signal_Priv(Semaphore * semaphore)
 {
 	CriticalSection _cs_;
+	MACS_TRACE(SemaphoreSignal, Trace::Id(semaphore), 0);
 
 	if ( semaphore->m_count == semaphore->m_max_count )	
 		return ResultErrorInvalidState;
@@ -83,8 +103,122 @@ Result Semaphore::Signal_Priv(Semaphore * semaphore)
 		return semaphore->UnblockTask();
 
 	++ semaphore->m_count;
+#if MACS_WAIT_MULTIPLE
+	semaphore->NotifySelect(true, false);
+#endif
 
 	return ResultOk;
 }
 
+Result Semaphore::SignalN(size_t qty)
+{
+	if ( ! Sch().IsInitialized() || ! Sch().IsStarted() ) 
+		return ResultErrorInvalidState;
+	
+	if ( ! System::IsSysCallAllowed() )	
+		return ResultErrorSysCallNotAllowed;
+
+	if ( qty == 0 )
+		return ResultOk;
+
+#if MACS_IRQ_POST
+	if ( System::IsInInterrupt() && ! System::IsInSysCall() )
+		return Sch().PostFromIrq(this, reinterpret_cast<void*>(qty), NULL, EPM_Semaphore_SignalN_Priv);
+#endif
+
+	return System::IsInPrivOrIrq() ? SignalN_Priv(this, qty) 
+	                               : SvcExecPrivileged(this, reinterpret_cast<void*>(qty), NULL, EPM_Semaphore_SignalN_Priv);
+}
+
+Result Semaphore::SignalN_Priv(Semaphore * semaphore, size_t qty)
+{
+	CriticalSection _cs_;
+	MACS_TRACE(SemaphoreSignal, Trace::Id(semaphore), 0);
+
+	if ( qty > semaphore->m_max_count - semaphore->m_count )
+		return ResultErrorInvalidState;
+
+	// все задачи разблокируются в одной критической секции - переключение контекста однократное
+	for ( ; qty && semaphore->IsHolding(); -- qty )
+		semaphore->UnblockTask();
+
+	semaphore->m_count += qty;
+#if MACS_WAIT_MULTIPLE
+	if ( qty )
+		semaphore->NotifySelect(true, true);
+#endif
+
+	return ResultOk;
+}
+
+Result Semaphore::TryWaitN(size_t max_qty, size_t & qty)
+{
+	qty = 0;
+	if ( ! Sch().IsInitialized() || ! Sch().IsStarted() ) 
+		return ResultErrorInvalidState;
+	
+	if ( ! System::IsSysCallAllowed() )	
+		return ResultErrorSysCallNotAllowed;
+
+	return System::IsInPrivOrIrq() ? TryWaitN_Priv(this, max_qty, & qty) 
+	                               : SvcExecPrivileged(this, reinterpret_cast<void*>(max_qty), & qty, EPM_Semaphore_TryWaitN_Priv);
+}
+
+Result Semaphore::TryWaitN_Priv(Semaphore * semaphore, size_t max_qty, size_t * qty)
+{
+	CriticalSection _cs_;
+
+	* qty = semaphore->m_count < max_qty ? semaphore->m_count : max_qty;
+	semaphore->m_count -= * qty;
+	return ResultOk;
+}
+
+#if MACS_SYNC_FAST_PATH
+// Изменение счетчика без обращения к ядру. Вход в любое исключение сбрасывает монитор 
+// эксклюзивного доступа, поэтому если между LDREX и STREX ядро изменило семафор 
+// (в том числе заблокировало на нем задачу), запись не состоится и попытка будет повторена.
+// На ядрах без LDREX/STREX эмуляция не защищает от прерываний, поэтому там всегда работает ядро.
+// При отказе от записи монитор сбрасывается (CLREX), чтобы открытый LDREX не остался после выхода.
+bool Semaphore::TryDecrementExcl()
+{
+#if MACS_MCU_CORE >= MACS_CORTEX_M3
+	for (;;) {
+		uint32_t cnt = MACS_LDREXW((ulong *) & m_count);
+		if ( ! cnt ) {
+			__CLREX();
+			return false;
+		}
+		if ( ! MACS_STREXW(cnt - 1, (ulong *) & m_count) )
+			return true;
+	}
+#else
+	return false;
+#endif
+}
+
+bool Semaphore::TryIncrementExcl()
+{
+#if MACS_MCU_CORE >= MACS_CORTEX_M3
+	for (;;) {
+		uint32_t cnt = MACS_LDREXW((ulong *) & m_count);
+		// наличие ожидающих задач проверяется после LDREX - их разблокирует ядро
+		if ( cnt >= m_max_count || * (Task * volatile *) & m_blocked_task_list ) {
+			__CLREX();
+			return false;
+		}
+#if MACS_WAIT_MULTIPLE
+		if ( * (SelectNode * volatile *) & m_select_list ) {
+			__CLREX();
+			return false;
+		}
+#endif
+		if ( ! MACS_STREXW(cnt + 1, (ulong *) & m_count) )
+			return true;
+	}
+#else
+	return false;
+#endif
+}
+#endif
+
 }	// namespace macs
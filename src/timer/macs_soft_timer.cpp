@@ -0,0 +1,256 @@
+/// @file macs_soft_timer.cpp
+/// @brief Программные таймеры.
+/// @details Программные таймеры позволяют выполнять действия через заданный интервал времени
+/// (однократно или периодически), не занимая аппаратных таймеров и не создавая отдельной задачи
+/// на каждый таймаут.
+/// @copyright AstroSoft Ltd, 2016
+
+#include <stdint.h>
+#include <limits.h>
+
+#include "macs_soft_timer.hpp"
+#include "macs_critical_section.hpp"
+
+#if MACS_SOFT_TIMERS
+
+namespace macs {
+
+SoftTimer::SoftTimer() :
+	m_expire(0),
+	m_period(0),
+	m_heap_idx(-1),
+	m_periodic(false)
+{}
+
+SoftTimer::~SoftTimer()
+{
+	if ( IsActive() )
+		Stop();
+}
+
+Result SoftTimer::Start(uint32_t period_ms, bool periodic)
+{
+	if ( ! Sch().IsInitialized() )
+		return ResultErrorInvalidState;
+
+	if ( ! System::IsSysCallAllowed() )
+		return ResultErrorSysCallNotAllowed;
+
+	if ( period_ms == 0 || period_ms == INFINITE_TIMEOUT )
+		return ResultErrorInvalidArgs;
+
+	uint32_t period_ticks = MsToTicks(period_ms);
+	if ( period_ticks == 0 )
+		period_ticks = 1;
+	// сравнение моментов срабатывания выполняется по модулю 2^32
+	if ( period_ticks > LONG_MAX )
+		return ResultErrorInvalidArgs;
+
+	return System::IsInPrivOrIrq() ? Start_Priv(this, period_ticks, periodic)
+	                               : SvcExecPrivileged(this, reinterpret_cast<void*>(period_ticks), reinterpret_cast<void*>(periodic), EPM_SoftTimer_Start_Priv);
+}
+
+Result SoftTimer::Reset()
+{
+	if ( m_period == 0 )	// таймер еще не запускался
+		return ResultErrorInvalidState;
+
+	if ( ! System::IsSysCallAllowed() )
+		return ResultErrorSysCallNotAllowed;
+
+	return System::IsInPrivOrIrq() ? Start_Priv(this, m_period, m_periodic)
+	                               : SvcExecPrivileged(this, reinterpret_cast<void*>(m_period), reinterpret_cast<void*>(m_periodic), EPM_SoftTimer_Start_Priv);
+}
+
+Result SoftTimer::Stop()
+{
+	if ( ! System::IsSysCallAllowed() )
+		return ResultErrorSysCallNotAllowed;
+
+	return System::IsInPrivOrIrq() ? Stop_Priv(this)
+	                               : SvcExecPrivileged(this, NULL, NULL, EPM_SoftTimer_Stop_Priv);
+}
+
+Result SoftTimer::Start_Priv(SoftTimer * timer, uint32_t period_ticks, bool periodic)
+{
+	CriticalSection _cs_;
+
+	SoftTimerRoom & room = SoftTimerRoom::GetInstance();
+	if ( timer->IsActive() )
+		room.Remove(timer);
+
+	timer->m_period = period_ticks;
+	timer->m_periodic = periodic;
+	timer->m_expire = Sch().GetTickCount() + period_ticks;
+
+	// очередь таймеров переполнена, следует увеличить MACS_SOFT_TIMER_QTY
+	return room.Insert(timer) ? ResultOk : ResultErrorInvalidState;
+}
+
+Result SoftTimer::Stop_Priv(SoftTimer * timer)
+{
+	CriticalSection _cs_;
+
+	if ( timer->IsActive() )
+		SoftTimerRoom::GetInstance().Remove(timer);
+
+	return ResultOk;
+}
+
+#if MACS_SOFT_TIMER_TASK
+// Задача таймеров вызывает обработчики сработавших таймеров по одному, вне критической секции.
+// При отсутствии сработавших таймеров задача блокируется, разблокирует ее системный тик.
+#if MACS_STATIC_SYS_TASKS
+typedef StaticTask<MACS_SOFT_TIMER_STACK_SIZE> SoftTimerTaskBase;
+#else
+typedef Task SoftTimerTaskBase;
+#endif
+class SoftTimerTask : public SoftTimerTaskBase
+{
+public:
+	SoftTimerTask() : SoftTimerTaskBase("TIMERS") { }
+
+private:
+	virtual void Execute() {
+		SoftTimerRoom & room = SoftTimerRoom::GetInstance();
+		for(;;) {
+			SoftTimer * timer;
+			{
+				CriticalSection _cs_;
+				timer = room.FetchExpired(Sch().GetTickCount());
+				if ( ! timer )
+					Sch().BlockCurrentTask(INFINITE_TIMEOUT);
+			}
+			if ( timer )
+				room.Run(timer);
+		}
+	}
+};
+#endif
+
+SoftTimerRoom::SoftTimerRoom() :
+	m_qty(0)
+#if MACS_SOFT_TIMER_TASK
+	, m_task(nullptr)
+#endif
+{}
+SoftTimerRoom SoftTimerRoom::m_instance;
+
+#if MACS_SOFT_TIMER_TASK
+Result SoftTimerRoom::StartTask()
+{
+	if ( m_task )
+		return ResultErrorInvalidState;
+
+#if MACS_STATIC_SYS_TASKS
+	static SoftTimerTask timerTask;
+	m_task = & timerTask;
+#else
+	m_task = new SoftTimerTask();
+#endif
+	return Task::Add(m_task, MACS_SOFT_TIMER_PRIORITY, Task::ModePrivileged, MACS_SOFT_TIMER_STACK_SIZE);
+}
+#endif
+
+bool SoftTimerRoom::Insert(SoftTimer * timer)
+{
+	if ( m_qty >= MACS_SOFT_TIMER_QTY )
+		return false;
+
+	Place(timer, m_qty ++);
+	SiftUp(timer->m_heap_idx);
+	return true;
+}
+
+void SoftTimerRoom::Remove(SoftTimer * timer)
+{
+	const int idx = timer->m_heap_idx;
+	_ASSERT(idx >= 0 && idx < m_qty && m_heap[idx] == timer);
+
+	timer->m_heap_idx = -1;
+	if ( idx == -- m_qty )
+		return;
+
+	// на место удаленного ставится последний элемент, который может сместиться как вверх, так и вниз
+	SoftTimer * last = m_heap[m_qty];
+	Place(last, idx);
+	SiftUp(idx);
+	if ( last->m_heap_idx == idx )
+		SiftDown(idx);
+}
+
+SoftTimer * SoftTimerRoom::FetchExpired(uint32_t now)
+{
+	if ( ! m_qty || ! IsExpired(m_heap[0], now) )
+		return nullptr;
+
+	SoftTimer * timer = m_heap[0];
+	if ( timer->m_periodic ) {
+		// очередной момент отсчитывается от предыдущего, чтобы период не "плыл"
+		timer->m_expire += timer->m_period;
+		SiftDown(0);
+	} else {
+		Remove(timer);
+	}
+	return timer;
+}
+
+uint32_t SoftTimerRoom::TicksToExpire(uint32_t now) const
+{
+	if ( ! m_qty )
+		return ULONG_MAX;
+
+	return IsExpired(m_heap[0], now) ? 0 : m_heap[0]->m_expire - now;
+}
+
+void SoftTimerRoom::Tick(uint32_t now)
+{
+	if ( ! m_qty || ! IsExpired(m_heap[0], now) )
+		return;
+
+#if MACS_SOFT_TIMER_TASK
+	if ( m_task && m_task->GetState() == Task::StateBlocked )
+		UnblockTask_Priv(& Sch(), m_task);
+#else
+	for(;;) {
+		SoftTimer * timer = FetchExpired(now);
+		if ( ! timer )
+			break;
+		Run(timer);
+	}
+#endif
+}
+
+void SoftTimerRoom::SiftUp(int idx)
+{
+	SoftTimer * timer = m_heap[idx];
+	while ( idx > 0 ) {
+		const int parent = (idx - 1) / 2;
+		if ( ! Preceeding(timer, m_heap[parent]) )
+			break;
+		Place(m_heap[parent], idx);
+		idx = parent;
+	}
+	Place(timer, idx);
+}
+
+void SoftTimerRoom::SiftDown(int idx)
+{
+	SoftTimer * timer = m_heap[idx];
+	for(;;) {
+		int child = 2 * idx + 1;
+		if ( child >= m_qty )
+			break;
+		if ( child + 1 < m_qty && Preceeding(m_heap[child + 1], m_heap[child]) )
+			++ child;
+		if ( ! Preceeding(m_heap[child], timer) )
+			break;
+		Place(m_heap[child], idx);
+		idx = child;
+	}
+	Place(timer, idx);
+}
+
+}	// namespace macs
+
+#endif
@@ -4,3 +4,6 @@
 #define MACS_USE_MPU             0
 #define MACS_MPU_PROTECT_NULL    0
 #define MACS_MPU_PROTECT_STACK   0
+
+#define MACS_TICKLESS_IDLE       0
+#define MACS_IRQ_QTY             32
@@ -1,3 +1,9 @@
 #pragma once
 
 #define MACS_BKPT(num) __asm volatile ("bkpt %0" : : "i"(num))
+
+// Размещение переменной в указанной секции компоновщика (указывается после объявления)
+#define MACS_SECTION(name) @ name
+
+// Адрес возврата текущей функции (вызывается в ее начале)
+#define MACS_RETURN_ADDRESS() ((void *) __get_LR())
@@ -1,3 +1,9 @@
 #pragma once
 
 #define MACS_BKPT(num) __asm volatile ("bkpt "#num)
+
+// Размещение переменной в указанной секции компоновщика (указывается после объявления)
+#define MACS_SECTION(name) __attribute__((section(name)))
+
+// Адрес возврата текущей функции (вызывается в ее начале)
+#define MACS_RETURN_ADDRESS() ((void *) __return_address())
@@ -2,6 +2,7 @@
 
 #include "macs_system.hpp"
 #include "macs_scheduler.hpp"
+#include "macs_memory_manager.hpp"
 
 #if MACS_MCU_CORE >= MACS_CORTEX_M3
 static const uint32_t DISABLE_INTERRUPTS_MASK = System::MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - __NVIC_PRIO_BITS);
@@ -80,6 +81,13 @@ bool SystemBase::InitScheduler()
 	NVIC_SetPriority(PendSV_IRQn, INTERRUPT_MIN_PRIORITY);
 	NVIC_SetPriority(SysTick_IRQn, INTERRUPT_MIN_PRIORITY);
 
+#if (__FPU_USED == 1)
+	// Автоматическое и отложенное сохранение контекста FPU: место под S0-S15 в аппаратном фрейме 
+	// резервируется только при CONTROL.FPCA, а сами регистры записываются, только если обработчик 
+	// выполнит команду FPU. S16-S31 сохраняет PendSV только для расширенного фрейма (бит 4 EXC_RETURN)
+	FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+#endif
+
 	SystemCoreClockUpdate();
 
 	return SetTickRate(m_tick_rate_hz);
@@ -93,6 +101,11 @@ void SystemBase::SwitchContext()
 	__ISB();
 }
 
+void SystemBase::CancelSwitchContext()
+{
+	SCB->ICSR = SCB_ICSR_PENDSVCLR_Msk;
+}
+
 #if MACS_MCU_CORE >= MACS_CORTEX_M3
 ulong SystemBase::GetCurCpuTick()
 {
@@ -277,6 +290,77 @@ void SystemBase::EnterSleepMode()
 	__WFI();
 }
 
+#if MACS_TICKLESS_IDLE
+void SystemBase::DisableAllIrq()
+{
+	__disable_irq();
+}
+
+void SystemBase::EnableAllIrq()
+{
+	__enable_irq();
+}
+
+uint32_t SystemBase::SleepTicks(uint32_t max_ticks)
+{
+	const uint32_t tick_len = SystemCoreClock / m_tick_rate_hz;
+	const uint32_t max_qty = SysTick_LOAD_RELOAD_Msk / tick_len;
+	if ( max_ticks > max_qty )
+		max_ticks = max_qty;
+	if ( max_ticks < 2 ) {
+		EnterSleepMode();
+		return 0;
+	}
+
+	// CTRL записывается константами: любое чтение CTRL сбрасывает COUNTFLAG, по которому ниже определяется,
+	// истек ли интервал сна
+	const uint32_t ctrl_stop = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+	const uint32_t ctrl_run = ctrl_stop | SysTick_CTRL_ENABLE_Msk;
+
+	SysTick->CTRL = ctrl_stop;
+	// если тик уже наступил, то засыпать нельзя - его нужно обработать
+	if ( SCB->ICSR & SCB_ICSR_PENDSTSET_Msk ) {
+		SysTick->CTRL = ctrl_run;
+		return 0;
+	}
+
+	// остаток текущего тика плюс целые тики до пробуждения
+	const uint32_t reload = SysTick->VAL + tick_len * (max_ticks - 1);
+	SysTick->LOAD = reload;
+	SysTick->VAL = 0;	// запись VAL сбрасывает и COUNTFLAG
+	SysTick->CTRL = ctrl_run;
+
+	EnterSleepMode();
+	__ISB();
+
+	// счетчик останавливается до чтения COUNTFLAG: иначе обнуление между чтением и остановкой 
+	// было бы потеряно, и пробуждение по SysTick принято за пробуждение другим прерыванием
+	SysTick->CTRL = ctrl_stop;
+	const bool expired = (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk);
+
+	uint32_t passed;
+	if ( expired ) {
+		// проспали весь интервал - последний тик учтет обработчик SysTick, остаток текущего тика 
+		// отсчитывается от момента перезагрузки таймера
+		uint32_t rest = (tick_len - 1) - (reload - SysTick->VAL);
+		if ( rest == 0 || rest > tick_len - 1 )
+			rest = tick_len - 1;
+		SysTick->LOAD = rest;
+		passed = max_ticks - 1;
+	} else {
+		// разбудило другое прерывание
+		const uint32_t spent = tick_len * max_ticks - SysTick->VAL;
+		passed = spent / tick_len;
+		SysTick->LOAD = (passed + 1) * tick_len - spent;
+	}
+	SysTick->VAL = 0;
+	SysTick->CTRL = ctrl_run;
+	SysTick->LOAD = tick_len - 1;	// вступит в силу со следующего тика
+
+	return passed;
+}
+#endif
+
 StackPtr::CHECK_RES StackPtr::Check(StackPtr marg, size_t len)
 {
 	if (*marg.m_sp != StackPtr::TOP_MARKER)
@@ -321,13 +405,19 @@ void TaskStack::PreparePlatformSpecific(size_t len, void * this_ptr, void (*run_
 	hw_frame.R0 = reinterpret_cast<uint32_t>(this_ptr);
 }
 
-void TaskStack::BuildPlatformSpecific(size_t guard, size_t len)
+void TaskStack::BuildPlatformSpecific(size_t guard, size_t len, size_t min_len)
 {
 	if (!m_is_alien_mem) {
-		m_len = (len < MIN_SIZE ? MIN_SIZE : (len <= MAX_SIZE ? len : MAX_SIZE));
+		m_len = (len < min_len ? min_len : (len <= MAX_SIZE ? len : MAX_SIZE));
+#if MACS_MEM_STACK_FAST
+		// стеки в быстрой памяти (при ее наличии) ускоряют задачи, активно использующие стек;
+		// память освобождается оператором delete, как и выделенная new
+		m_memory = static_cast<uint32_t *>(MemoryManager::Allocate((m_len + guard) * sizeof(uint32_t), MemPolicyFast));
+#else
 		m_memory = new uint32_t[m_len + guard];
+#endif
 	} else {
-		_ASSERT(len >= MIN_SIZE + guard && len <= MAX_SIZE);
+		_ASSERT(len >= min_len + guard && len <= MAX_SIZE);
 		m_len = len - guard;
 	}
 
@@ -94,21 +94,24 @@ private:
 	/// @brief Размер области стека, достаточной для экономной работы задачи
 	static const size_t WORK_SIZE = 0x10;
 public:
-	/// @brief Минимальный размер стека в словах.
-	static const size_t MIN_SIZE
-#if (__FPU_USED == 1)
-	/// @details Размер складывается из:
-	/// + аппаратно сохраняемой части контекста в 0x1A или 0x1B слов (в зависимости от выравнивания DWORD),
-	/// + программно сохраняемая часть контекста в 0x19 слов (что даёт максимум 0x34 слова на контекст),
-	/// + 0x10 слов для нужд самой задачи.
-	= 0x34 + WORK_SIZE;
-#else
+	/// @brief Минимальный размер стека задачи, не использующей FPU, в словах.
 	/// @details Размер складывается из:
 	/// + аппаратно сохраняемой части контекста в 0x08 или 0x09 слов (в зависимости от выравнивания DWORD),
 	/// + программно сохраняемая часть контекста в 0x09 слов (что даёт максимум 0x12 слов на контекст),
 	/// + 0x10 слов для нужд самой задачи.
-	= 0x12 + WORK_SIZE;
+	static const size_t MIN_NOFPU_SIZE = 0x12 + WORK_SIZE;
+	/// @brief Размер контекста FPU в словах.
+#if (__FPU_USED == 1)
+	/// @details Аппаратно сохраняются S0-S15 и FPSCR (0x12 слов), программно - S16-S31 (0x10 слов).
+	/// Расширенный фрейм создается только для задач, выполнивших хотя бы одну команду FPU (CONTROL.FPCA).
+	static const size_t FPU_CONTEXT_SIZE = 0x22;
+#else
+	static const size_t FPU_CONTEXT_SIZE = 0;
 #endif
+	/// @brief Минимальный размер стека в словах.
+	/// @details Включает контекст FPU, поскольку любая задача может выполнить команду FPU
+	/// (в том числе в библиотечном коде). Задача, объявившая отказ от FPU, может иметь стек MIN_NOFPU_SIZE.
+	static const size_t MIN_SIZE = MIN_NOFPU_SIZE + FPU_CONTEXT_SIZE;
 	/// @brief Размер стека, достаточный для работы большинства задач
 	static const size_t ENOUGH_SIZE
 #if MACS_MCU_CORE == MACS_CORTEX_M3
@@ -126,7 +129,7 @@ private:
 	// Минимальный остаток стека в словах до автоматического увеличения.
 	static const size_t MIN_REST = 2 * WORK_SIZE;
 	// Шаг увеличения стека в словах
-	static const int GROW_SIZE = MIN_SIZE;
+	static const int GROW_SIZE = MIN_NOFPU_SIZE;
 public:
 	// Максимальный размер стека в словах.
 	static const size_t MAX_SIZE = MACS_MAX_STACK_SIZE - GUARD_SIZE;
@@ -154,9 +157,9 @@ public:
 	{
 		Free();
 	}
-	void Build(size_t len, uint32_t * mem = nullptr);
-	void BuildPlatformSpecific(size_t guard, size_t len);
-	void Prepare(size_t len, void * this_ptr, void (*run_func)(void), void (*exit_func)(void));
+	void Build(size_t len, uint32_t * mem = nullptr, size_t min_len = MIN_SIZE);
+	void BuildPlatformSpecific(size_t guard, size_t len, size_t min_len);
+	void Prepare(size_t len, void * this_ptr, void (*run_func)(void), void (*exit_func)(void), size_t min_len = MIN_SIZE);
 	void Free();
 	void Instrument()
 	{
@@ -236,6 +239,10 @@ public:
 		return false;
 	} // todo реализовать для Cortex ?
 
+	// Регистрирует в распределителе памяти дополнительные области динамической памяти платформы
+	// (MemoryManager::AddRegion). Вызывается при инициализации кучи, по умолчанию областей нет.
+	static inline void InitHeapRegions() {}
+
 	// Определяет находимся ли мы в обработчике прерывания.
 	// Вызов SVC также считается прерыванием.
 	static bool IsInInterrupt();
@@ -281,6 +288,9 @@ public:
 	// Выдает запрос на переключение контекста.
 	static void SwitchContext();
 
+	// Снимает запрос на переключение контекста.
+	static void CancelSwitchContext();
+
 	// Производит первичную инициализацию планировщика.
 	static bool InitScheduler();
 
@@ -397,6 +407,19 @@ public:
 
 	// Перевод процессора в спящий режим.
 	static void EnterSleepMode();
+
+#if MACS_TICKLESS_IDLE
+	// Запрещает/разрешает все прерывания (PRIMASK) независимо от их приоритета.
+	// Используется при входе в сон без тиков: процессор просыпается по прерыванию, но его обработка
+	// начнется только после того, как ядро учтет пропущенные тики.
+	static void DisableAllIrq();
+	static void EnableAllIrq();
+
+	// Перевод процессора в спящий режим на время до max_ticks системных тиков с остановкой периодических прерываний.
+	// Вызывается при запрещенных прерываниях (DisableAllIrq). Возвращает количество полностью прошедших тиков,
+	// тик, на котором сон завершился, обрабатывается обычным образом.
+	static uint32_t SleepTicks(uint32_t max_ticks);
+#endif
 };
 
 #if (MACS_MCU_CORE < MACS_CORTEX_M3) || (MACS_MCU_CORE == MACS_TS201)
@@ -410,3 +433,22 @@ extern uint32_t MACS_STREXW(uint32_t val, void * ptr);
 #define MACS_STREXB  __STREXB
 #define MACS_STREXW  __STREXW
 #endif
+
+// Подсчет количества старших нулевых битов слова (для нуля результат равен 32).
+#if MACS_MCU_CORE < MACS_CORTEX_M3
+// На ядрах M0/M1 нет инструкции CLZ, поэтому используется двоичный поиск.
+inline uint32_t MACS_CLZ(uint32_t val)
+{
+	if ( ! val )
+		return 32;
+	uint32_t n = 0;
+	if ( ! (val & 0xFFFF0000u) ) { n += 16; val <<= 16; }
+	if ( ! (val & 0xFF000000u) ) { n +=  8; val <<=  8; }
+	if ( ! (val & 0xF0000000u) ) { n +=  4; val <<=  4; }
+	if ( ! (val & 0xC0000000u) ) { n +=  2; val <<=  2; }
+	if ( ! (val & 0x80000000u) ) { n +=  1; }
+	return n;
+}
+#else
+#define MACS_CLZ  __CLZ
+#endif
@@ -7,6 +7,7 @@
 #include "stm32f4xx_hal.h"
 
 #include "macs_system.hpp"
+#include "macs_memory_manager.hpp"
 
 /* System Clock Configuration */
 void System::InitClock()
@@ -70,6 +71,18 @@ void System::InitCpu()
 	InitClock();
 }
 
+#if MACS_MEM_TLSF && MACS_CCM_HEAP_SIZE
+// CCM (64 Кбайт) работает без тактов ожидания, но недоступна для DMA
+static uint64_t ccmHeapMem[MACS_CCM_HEAP_SIZE / sizeof(uint64_t)] MACS_SECTION(".noinit.CCMRAM");
+#endif
+
+void System::InitHeapRegions()
+{
+#if MACS_MEM_TLSF && MACS_CCM_HEAP_SIZE
+	MemoryManager::AddRegion("ccm", ccmHeapMem, sizeof(ccmHeapMem), MemAttrFast);
+#endif
+}
+
 void System::HardFaultHandler()
 {
 	static uint32_t icsr = SCB->ICSR;
@@ -19,6 +19,10 @@
 	#define MACS_HEAP_SIZE (32 KILO_B)
 #endif	
 
+#ifndef MACS_CCM_HEAP_SIZE
+	#define MACS_CCM_HEAP_SIZE (32 KILO_B)	///< Размер области динамической памяти в CCM (0 - не использовать CCM)
+#endif
+
 /// @brief Класс, содержащий реализацию платформозависимых методов
 class System: public SystemBase
 {
@@ -26,6 +30,7 @@ public:
 	static const uint32_t HEAP_SIZE = MACS_HEAP_SIZE;
 
 	static void InitCpu();
+	static void InitHeapRegions();
 	static void HardFaultHandler();
 
 	static bool SetUpIrqHandling(int irq_num, bool vector, bool enable);
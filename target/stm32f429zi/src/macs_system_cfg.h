@@ -6,3 +6,6 @@
 #define MACS_USE_MPU             1
 #define MACS_MPU_PROTECT_NULL    1     ///< Защита памяти по нулевому адресу от доступа.
 #define MACS_MPU_PROTECT_STACK   1     ///< Аппаратная защита стека от переполнения.
+
+#define MACS_TICKLESS_IDLE       0     ///< Остановка системного таймера в задаче холостого хода до ближайшего пробуждения задач.
+#define MACS_IRQ_QTY             91    ///< Количество внешних прерываний контроллера.
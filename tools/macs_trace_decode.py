@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""Декодер трассировки ядра МАКС.
+
+Преобразует вывод команды терминала TraceTemrCmd (см. src/lib/macs_term_cmd.cpp)
+в хронологию событий. Строки, не относящиеся к трассировке, пропускаются, поэтому
+на вход можно подавать полный протокол терминала.
+
+Использование:
+    macs_trace_decode.py [файл]          (по умолчанию читается stdin)
+"""
+
+import sys
+
+# Должно совпадать с macs::Trace::Kind (include/macs_trace.hpp)
+KINDS = {
+    1: 'SWITCH',
+    2: 'BLOCK',
+    3: 'UNBLOCK',
+    4: 'IRQ',
+    5: 'EVENT_RAISE',
+    6: 'EVENT_WAIT',
+    7: 'MUTEX_LOCK',
+    8: 'MUTEX_UNLOCK',
+    9: 'SEM_WAIT',
+    10: 'SEM_SIGNAL',
+    11: 'NOTIFY',
+    12: 'WAIT_NOTIFY',
+    13: 'EVGROUP_SET',
+    14: 'EVGROUP_WAIT',
+}
+
+# Должно совпадать с macs::Task::UnblockReason
+UNBLOCK_REASONS = {0: 'none', 1: 'request', 2: 'timeout', 3: 'irq'}
+
+# Должно совпадать с macs::Task::NotifyAction
+NOTIFY_ACTIONS = {0: 'set_bits', 1: 'increment', 2: 'overwrite'}
+
+TASK_KINDS = (1, 2, 3, 11, 12)
+
+
+def parse(lines):
+    freq = None
+    tasks = {}
+    recs = []
+    for line in lines:
+        f = line.split()
+        if not f:
+            continue
+        if f[0] == 'MACS-TRACE' and len(f) >= 3:
+            freq = int(f[2])
+            tasks.clear()
+            del recs[:]
+        elif f[0] == 'T' and len(f) >= 2:
+            tasks[int(f[1], 16)] = ' '.join(f[2:]) or '?'
+        elif f[0] == 'R' and len(f) == 5:
+            recs.append(tuple(int(x, 16) for x in f[1:]))
+    return freq, tasks, recs
+
+
+def describe(kind, arg, ident, tasks):
+    name = KINDS.get(kind, 'KIND_%d' % kind)
+    if kind in TASK_KINDS:
+        what = '%s[%04x]' % (tasks.get(ident, '?'), ident)
+    elif kind == 4:
+        irq = ident - 0x10000 if ident & 0x8000 else ident
+        what = 'irq %d' % irq
+    else:
+        what = 'obj %04x' % ident
+
+    if kind == 1:
+        what += ' prio %d' % arg
+    elif kind == 3:
+        what += ' (%s)' % UNBLOCK_REASONS.get(arg, arg)
+    elif kind == 11:
+        what += ' (%s)' % NOTIFY_ACTIONS.get(arg, arg)
+    return '%-12s %s' % (name, what)
+
+
+def main():
+    src = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    freq, tasks, recs = parse(src)
+    if freq is None:
+        sys.exit('заголовок MACS-TRACE не найден')
+    if not recs:
+        return
+
+    # метки времени 32-битные, поэтому отсчитываются приращениями по модулю 2^32
+    t = 0
+    prev = recs[0][0]
+    for stamp, kind, arg, ident in recs:
+        t += (stamp - prev) & 0xFFFFFFFF
+        prev = stamp
+        print('%12.3f us  %s' % (t * 1e6 / freq, describe(kind, arg, ident, tasks)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,21 @@
+/// @file macs_system.hpp
+/// @brief Замена системного заголовка для сборки TLSF на компьютере разработчика.
+/// @details Содержит только то, что использует src/memory/macs_tlsf.hpp/.cpp.
+
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef nullptr
+	#define nullptr NULL
+#endif
+#define CLS_COPY(cls) cls(const cls &); cls & operator = (const cls &);
+#define loop(type, i, lim) for ( type i = 0; i < (lim); ++ i )
+#define _ASSERT assert
+#define MACS_CLZ(val) ((val) ? (uint32_t) __builtin_clz(val) : 32u)
+
+typedef unsigned char byte;
+typedef unsigned int uint;
+typedef unsigned long ulong;
@@ -0,0 +1,120 @@
+/// @file macs_tlsf_stress.cpp
+/// @brief Нагрузочный тест распределителя TLSF на компьютере разработчика.
+/// @details Выполняет случайную последовательность выделений и освобождений (по умолчанию 2 млн операций)
+/// над кучей фиксированного размера и проверяет: целостность данных блоков, выравнивание, возврат кучи
+/// в исходное состояние (один свободный блок) после освобождения всех блоков. Фрагментация оценивается
+/// как доля свободной памяти, не входящей в наибольший свободный блок.
+///
+/// Сборка и запуск (из корня репозитория):
+///     g++ -O2 -std=gnu++98 -Itools/tlsf_stress -Isrc/memory -o tlsf_stress tools/tlsf_stress/macs_tlsf_stress.cpp src/memory/macs_tlsf.cpp
+///     ./tlsf_stress [операций] [размер кучи в Кбайт] [seed]
+/// @copyright AstroSoft Ltd, 2016
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macs_tlsf.hpp"
+
+using namespace macs;
+
+static const size_t SLOT_QTY = 400;        // одновременно живущих блоков не более
+static const size_t SAMPLE_PERIOD = 1000;  // период замера фрагментации (операций)
+
+static TlsfHeap s_heap;
+static uint32_t s_seed;
+
+// Собственный генератор, чтобы последовательность не зависела от библиотеки C
+static uint32_t Rand()
+{
+	s_seed = s_seed * 1664525u + 1013904223u;
+	return s_seed >> 8;
+}
+
+// Типичная для встраиваемых задач смесь: 2/3 мелких запросов, остальные до 1 Кбайт
+static size_t RandSize()
+{
+	return Rand() % 3 ? Rand() % 64 + 1 : Rand() % 1024 + 1;
+}
+
+int main(int argc, char * argv[])
+{
+	const ulong ops = argc > 1 ? strtoul(argv[1], nullptr, 0) : 2000000ul;
+	const size_t heap_size = (argc > 2 ? strtoul(argv[2], nullptr, 0) : 64) * 1024;
+	s_seed = argc > 3 ? strtoul(argv[3], nullptr, 0) : 1;
+
+	uint64_t * mem = new uint64_t[heap_size / sizeof(uint64_t)];
+	s_heap.Init(mem, heap_size);
+	const size_t initial_free = s_heap.GetFreeSize();
+
+	byte * ptrs[SLOT_QTY];
+	size_t sizes[SLOT_QTY];
+	memset(ptrs, 0, sizeof(ptrs));
+
+	ulong allocs = 0, fails = 0, frees = 0, samples = 0;
+	size_t live = 0, peak_live = 0, max_blocks = 0;
+	double frag_sum = 0, frag_max = 0;
+
+	loop ( ulong, op, ops ) {
+		const size_t slot = Rand() % SLOT_QTY;
+		if ( ptrs[slot] ) {
+			loop ( size_t, index, sizes[slot] ) {
+				if ( ptrs[slot][index] != (byte) slot ) {
+					printf("FAIL: block %u corrupted at operation %lu\n", (uint) slot, op);
+					return 1;
+				}
+			}
+			s_heap.Free(ptrs[slot]);
+			ptrs[slot] = nullptr;
+			live -= sizes[slot];
+			++ frees;
+		} else {
+			sizes[slot] = RandSize();
+			ptrs[slot] = static_cast<byte *>(s_heap.Alloc(sizes[slot]));
+			if ( ! ptrs[slot] ) {
+				++ fails;
+			} else {
+				if ( ((uintptr_t) ptrs[slot] & 7) != 0 || TlsfHeap::BlockSize(ptrs[slot]) < sizes[slot] ) {
+					printf("FAIL: bad block %p size %u at operation %lu\n", ptrs[slot], (uint) sizes[slot], op);
+					return 1;
+				}
+				memset(ptrs[slot], (int) slot, sizes[slot]);
+				live += sizes[slot];
+				++ allocs;
+			}
+		}
+
+		if ( live > peak_live )
+			peak_live = live;
+		if ( s_heap.GetFreeBlocks() > max_blocks )
+			max_blocks = s_heap.GetFreeBlocks();
+		if ( op % SAMPLE_PERIOD == 0 && s_heap.GetFreeSize() ) {
+			const double frag = 1.0 - (double) s_heap.GetLargestFree() / s_heap.GetFreeSize();
+			frag_sum += frag;
+			if ( frag > frag_max )
+				frag_max = frag;
+			++ samples;
+		}
+	}
+
+	loop ( size_t, slot, SLOT_QTY ) {
+		if ( ptrs[slot] )
+			s_heap.Free(ptrs[slot]);
+	}
+
+	printf("operations:        %lu (heap %u bytes, seed %lu)\n", ops, (uint) heap_size, (ulong) (argc > 3 ? strtoul(argv[3], nullptr, 0) : 1));
+	printf("allocations:       %lu ok, %lu failed (%.3f%%)\n", allocs, fails, allocs + fails ? 100.0 * fails / (allocs + fails) : 0.0);
+	printf("frees:             %lu\n", frees);
+	printf("peak live data:    %u bytes (%.1f%% of heap)\n", (uint) peak_live, 100.0 * peak_live / heap_size);
+	printf("max free blocks:   %u\n", (uint) max_blocks);
+	printf("fragmentation:     avg %.1f%%, max %.1f%% (1 - largest free / free)\n",
+	       samples ? 100.0 * frag_sum / samples : 0.0, 100.0 * frag_max);
+
+	// после освобождения всех блоков соседние свободные блоки должны слиться в один
+	const bool restored = s_heap.GetFreeBlocks() == 1 && s_heap.GetFreeSize() == initial_free;
+	printf("heap restored:     %s (free blocks %u, free %u of %u bytes)\n", restored ? "yes" : "NO",
+	       (uint) s_heap.GetFreeBlocks(), (uint) s_heap.GetFreeSize(), (uint) initial_free);
+
+	delete [] mem;
+	return restored ? 0 : 1;
+}